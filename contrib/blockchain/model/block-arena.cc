@@ -0,0 +1,70 @@
+#include "ns3/assert.h"
+
+#include "block-arena.h"
+
+namespace ns3 {
+    BlockArena::BlockArena(uint32_t blocksPerSlab)
+        : m_blocksPerSlab(blocksPerSlab), m_next(0), m_live(0) {
+        NS_ASSERT(m_blocksPerSlab > 0);
+    }
+
+    BlockArena::~BlockArena(void) {}
+
+    BlockHandle BlockArena::Allocate(const LedgerBlock &block) {
+        BlockHandle handle;
+
+        if(!m_free.empty()) {
+            handle = m_free.back();
+            m_free.pop_back();
+        } else {
+            if(m_next == m_slabs.size() * m_blocksPerSlab) {
+                m_slabs.push_back(std::unique_ptr<LedgerBlock[]>(new LedgerBlock[m_blocksPerSlab]));
+                m_used.resize(m_slabs.size() * m_blocksPerSlab, false);
+            }
+            handle = m_next++;
+        }
+
+        m_slabs[handle / m_blocksPerSlab][handle % m_blocksPerSlab] = block;
+        m_used[handle] = true;
+        m_live++;
+        return handle;
+    }
+
+    void BlockArena::Release(BlockHandle handle) {
+        NS_ASSERT(IsValid(handle));
+
+        // Drop the reference now rather than when the slot is reused
+        LedgerBlock &entry = m_slabs[handle / m_blocksPerSlab][handle % m_blocksPerSlab];
+        entry.block.reset();
+        entry.view = Block();
+        m_used[handle] = false;
+        m_free.push_back(handle);
+        m_live--;
+    }
+
+    void BlockArena::Clear(void) {
+        m_slabs.clear();
+        m_used.clear();
+        m_free.clear();
+        m_next = 0;
+        m_live = 0;
+    }
+
+    bool BlockArena::IsValid(BlockHandle handle) const {
+        return handle < m_next && m_used[handle];
+    }
+
+    LedgerBlock& BlockArena::Get(BlockHandle handle) {
+        NS_ASSERT(IsValid(handle));
+        return m_slabs[handle / m_blocksPerSlab][handle % m_blocksPerSlab];
+    }
+
+    const LedgerBlock& BlockArena::Get(BlockHandle handle) const {
+        NS_ASSERT(IsValid(handle));
+        return m_slabs[handle / m_blocksPerSlab][handle % m_blocksPerSlab];
+    }
+
+    uint32_t BlockArena::GetSize(void) const {
+        return m_live;
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef BLOCK_ARENA_H
+#define BLOCK_ARENA_H
+
+#include <memory>
+#include <vector>
+#include <stdint.h>
+
+#include "block.h"
+
+namespace ns3 {
+    typedef uint32_t BlockHandle;
+    const BlockHandle INVALID_BLOCK_HANDLE = 0xffffffff;
+
+    /*
+     * A block as held by one ledger. The block itself is shared and immutable,
+     * with no reception details; view is this node's copy of it, which shares
+     * its transactions and carries the node's own reception details.
+     */
+    struct LedgerBlock {
+        std::shared_ptr<const Block> block;
+        Block view;
+    };
+
+    /*
+     * Slab allocator for the blocks of a ledger. Entries are stored in fixed size
+     * slabs that are never reallocated, so a handle (and a pointer obtained from
+     * it) stays valid across later insertions until the entry is released.
+     */
+    class BlockArena {
+        public:
+            BlockArena(uint32_t blocksPerSlab = 256);
+            virtual ~BlockArena(void);
+
+            BlockHandle Allocate(const LedgerBlock &block);
+            void Release(BlockHandle handle);
+            /* Releases every block, handles start again from 0 */
+            void Clear(void);
+
+            bool IsValid(BlockHandle handle) const;
+            LedgerBlock& Get(BlockHandle handle);
+            const LedgerBlock& Get(BlockHandle handle) const;
+
+            /* Number of live blocks */
+            uint32_t GetSize(void) const;
+
+        protected:
+            BlockArena(const BlockArena &);
+            BlockArena& operator = (const BlockArena &);
+
+            uint32_t m_blocksPerSlab;
+            uint32_t m_next;    // first never used slot
+            uint32_t m_live;
+
+            std::vector<std::unique_ptr<LedgerBlock[]>>    m_slabs;
+            std::vector<bool>                               m_used;
+            std::vector<BlockHandle>                        m_free;
+    };
+}
+
+#endif
@@ -0,0 +1,47 @@
+#include <cstdlib>
+#include <cerrno>
+#include <climits>
+#include <sstream>
+
+#include "block-id.h"
+
+namespace ns3 {
+    std::string BlockId::ToString(void) const {
+        std::ostringstream stringStream;
+        stringStream << *this;
+        return stringStream.str();
+    }
+
+    bool BlockId::FromString(const char *str, BlockId &id) {
+        char *end;
+
+        errno = 0;
+        long height = strtol(str, &end, 10);
+        if(end == str || *end != '/' || errno != 0 || height < INT_MIN || height > INT_MAX) {
+            return false;
+        }
+
+        const char *minerStr = end + 1;
+        long minerId = strtol(minerStr, &end, 10);
+        if(end == minerStr || *end != '\0' || errno != 0 || minerId < INT_MIN || minerId > INT_MAX) {
+            return false;
+        }
+
+        id = BlockId(height, minerId);
+        return true;
+    }
+
+    std::string TxId::ToString(void) const {
+        std::ostringstream stringStream;
+        stringStream << *this;
+        return stringStream.str();
+    }
+
+    std::ostream& operator << (std::ostream &os, const BlockId &id) {
+        return os << id.GetHeight() << "/" << id.GetMinerId();
+    }
+
+    std::ostream& operator << (std::ostream &os, const TxId &id) {
+        return os << id.GetNodeId() << "/" << id.GetTransId();
+    }
+}
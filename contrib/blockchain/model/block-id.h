@@ -0,0 +1,85 @@
+#ifndef BLOCK_ID_H
+#define BLOCK_ID_H
+
+#include <string>
+#include <functional>
+#include <ostream>
+#include <stdint.h>
+
+namespace ns3 {
+    /*
+     * Identity of a block, (height, minerId), packed in 64 bits. The textual
+     * "height/minerId" form is only used on the wire and in logs.
+     */
+    class BlockId {
+        public:
+            BlockId(void) : m_id(0) {}
+            BlockId(int height, int minerId)
+                : m_id((static_cast<uint64_t>(static_cast<uint32_t>(height)) << 32) | static_cast<uint32_t>(minerId)) {}
+
+            int GetHeight(void) const { return static_cast<int32_t>(m_id >> 32); }
+            int GetMinerId(void) const { return static_cast<int32_t>(m_id & 0xffffffff); }
+            uint64_t GetPacked(void) const { return m_id; }
+
+            std::string ToString(void) const;
+            /* Parses "height/minerId"; returns false and leaves id untouched on malformed input */
+            static bool FromString(const char *str, BlockId &id);
+
+            bool operator == (const BlockId &other) const { return m_id == other.m_id; }
+            bool operator != (const BlockId &other) const { return m_id != other.m_id; }
+            bool operator < (const BlockId &other) const { return m_id < other.m_id; }
+
+        private:
+            uint64_t m_id;
+    };
+
+    /*
+     * Identity of a transaction, (nodeId, transId), packed in 64 bits.
+     */
+    class TxId {
+        public:
+            TxId(void) : m_id(0) {}
+            TxId(int nodeId, int transId)
+                : m_id((static_cast<uint64_t>(static_cast<uint32_t>(nodeId)) << 32) | static_cast<uint32_t>(transId)) {}
+
+            int GetNodeId(void) const { return static_cast<int32_t>(m_id >> 32); }
+            int GetTransId(void) const { return static_cast<int32_t>(m_id & 0xffffffff); }
+            uint64_t GetPacked(void) const { return m_id; }
+
+            std::string ToString(void) const;
+
+            bool operator == (const TxId &other) const { return m_id == other.m_id; }
+            bool operator != (const TxId &other) const { return m_id != other.m_id; }
+            bool operator < (const TxId &other) const { return m_id < other.m_id; }
+
+        private:
+            uint64_t m_id;
+    };
+
+    std::ostream& operator << (std::ostream &os, const BlockId &id);
+    std::ostream& operator << (std::ostream &os, const TxId &id);
+
+    /* 64-bit finalizer of MurmurHash3, spreads the packed ids over the hash buckets */
+    inline size_t MixId(uint64_t id) {
+        id ^= id >> 33;
+        id *= 0xff51afd7ed558ccdULL;
+        id ^= id >> 33;
+        id *= 0xc4ceb9fe1a85ec53ULL;
+        id ^= id >> 33;
+        return static_cast<size_t>(id);
+    }
+}
+
+namespace std {
+    template <>
+    struct hash<ns3::BlockId> {
+        size_t operator () (const ns3::BlockId &id) const { return ns3::MixId(id.GetPacked()); }
+    };
+
+    template <>
+    struct hash<ns3::TxId> {
+        size_t operator () (const ns3::TxId &id) const { return ns3::MixId(id.GetPacked()); }
+    };
+}
+
+#endif
@@ -0,0 +1,100 @@
+#include <algorithm>
+#include <utility>
+
+#include "block-store.h"
+
+namespace ns3 {
+    BlockStore::BlockStore(void)
+        : m_blocksPurgeAt(1024), m_headersPurgeAt(1024) {
+    }
+
+    BlockStore::~BlockStore(void) {}
+
+    /* Blocks are keyed by id alone, so the header fields are checked before sharing */
+    static bool IsSameHeader(const Block &stored, const Block &block) {
+        return stored.GetNonce() == block.GetNonce()
+               && stored.GetParentBlockMinerId() == block.GetParentBlockMinerId()
+               && stored.GetBlockSizeBytes() == block.GetBlockSizeBytes()
+               && stored.GetTimeStamp() == block.GetTimeStamp();
+    }
+
+    static bool IsSameBlock(const Block &stored, const Block &block) {
+        return IsSameHeader(stored, block) && stored.GetTransactionCount() == block.GetTransactionCount();
+    }
+
+    std::shared_ptr<const Block> BlockStore::Intern(const Block &block) {
+        std::weak_ptr<const Block> &entry = m_blocks[block.GetBlockId()];
+        std::shared_ptr<const Block> shared = entry.lock();
+
+        if(!shared) {
+            shared = std::make_shared<const Block>(block);
+            Store(m_blocks, m_blocksPurgeAt, entry, shared);
+        }
+        else if(!IsSameBlock(*shared, block)) {
+            return std::make_shared<const Block>(block);
+        }
+        return shared;
+    }
+
+    std::shared_ptr<const Block> BlockStore::Intern(Block &&block) {
+        std::weak_ptr<const Block> &entry = m_blocks[block.GetBlockId()];
+        std::shared_ptr<const Block> shared = entry.lock();
+
+        if(!shared) {
+            shared = std::make_shared<const Block>(std::move(block));
+            Store(m_blocks, m_blocksPurgeAt, entry, shared);
+        }
+        else if(!IsSameBlock(*shared, block)) {
+            return std::make_shared<const Block>(std::move(block));
+        }
+        return shared;
+    }
+
+    std::shared_ptr<const Block> BlockStore::InternHeader(const Block &block) {
+        std::weak_ptr<const Block> &entry = m_headers[block.GetBlockId()];
+        std::shared_ptr<const Block> shared = entry.lock();
+
+        if(shared && IsSameHeader(*shared, block)) {
+            return shared;
+        }
+
+        // Built field by field so the transactions are never copied
+        std::shared_ptr<const Block> header = std::make_shared<const Block>(block.GetBlockHeight(), block.GetMinerId(), block.GetNonce(),
+                                                                            block.GetParentBlockMinerId(), block.GetBlockSizeBytes(),
+                                                                            block.GetTimeStamp(), block.GetTimeReceived(), block.GetReceivedFromIpv4());
+        if(!shared) {
+            Store(m_headers, m_headersPurgeAt, entry, header);
+        }
+        return header;
+    }
+
+    uint32_t BlockStore::GetSize(void) {
+        Purge(m_blocks);
+        return m_blocks.size();
+    }
+
+    uint32_t BlockStore::GetHeaderSize(void) {
+        Purge(m_headers);
+        return m_headers.size();
+    }
+
+    void BlockStore::Store(BlockMap &blocks, size_t &purgeAt, std::weak_ptr<const Block> &entry, const std::shared_ptr<const Block> &shared) {
+        entry = shared;
+
+        // Expired entries are cleaned up whenever the map has doubled since the last purge
+        if(blocks.size() >= purgeAt) {
+            Purge(blocks);
+            purgeAt = std::max(purgeAt, 2 * blocks.size());
+        }
+    }
+
+    void BlockStore::Purge(BlockMap &blocks) {
+        for(auto it = blocks.begin(); it != blocks.end();) {
+            if(it->second.expired()) {
+                it = blocks.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+}
@@ -0,0 +1,50 @@
+#ifndef BLOCK_STORE_H
+#define BLOCK_STORE_H
+
+#include <memory>
+#include <unordered_map>
+#include <stdint.h>
+
+#include "block.h"
+
+namespace ns3 {
+    /*
+     * Process-wide store of immutable blocks shared by the ledgers of all the
+     * simulated nodes. A block is copied once, the first time any node stores
+     * it; every later ledger holding the same (height, minerId) gets a reference
+     * to that copy. Blocks are freed when the last ledger drops them.
+     * A block whose header or transaction count differs from the live copy
+     * under its id is given an unshared copy of its own instead.
+     *
+     * Use Singleton<BlockStore>::Get() to access it.
+     */
+    class BlockStore {
+        public:
+            BlockStore(void);
+            virtual ~BlockStore(void);
+
+            std::shared_ptr<const Block> Intern(const Block &block);
+            /* Takes the transactions of block instead of copying them when it is stored */
+            std::shared_ptr<const Block> Intern(Block &&block);
+            /* Shared copy of the block without its transactions */
+            std::shared_ptr<const Block> InternHeader(const Block &block);
+
+            /* Number of distinct blocks currently alive, with and without transactions */
+            uint32_t GetSize(void);
+            uint32_t GetHeaderSize(void);
+
+        protected:
+            typedef std::unordered_map<BlockId, std::weak_ptr<const Block>> BlockMap;
+
+            /* Records a newly shared block under entry and purges expired entries once the map has doubled */
+            static void Store(BlockMap &blocks, size_t &purgeAt, std::weak_ptr<const Block> &entry, const std::shared_ptr<const Block> &shared);
+            static void Purge(BlockMap &blocks);
+
+            BlockMap m_blocks;
+            BlockMap m_headers;
+            size_t m_blocksPurgeAt;
+            size_t m_headersPurgeAt;
+    };
+}
+
+#endif
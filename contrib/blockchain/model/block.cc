@@ -1,3 +1,7 @@
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
 #include "block.h"
 
 namespace ns3 {
@@ -13,10 +17,10 @@ namespace ns3 {
         m_timeReceived = timeReceived;
         m_receivedFromIpv4 = receivedFromIpv4;
         m_totalTransactions = 0;
+        m_transactions = GetEmptyTransactions();
     }
 
-    Block::Block() {
-        Block(0,0,0,0,0,0.0,0.0,Ipv4Address("0.0.0.0"));
+    Block::Block() : Block(0,0,0,0,0,0.0,0.0,Ipv4Address("0.0.0.0")) {
     }
 
     Block::Block(const Block &blockSource) {
@@ -29,7 +33,22 @@ namespace ns3 {
         m_timeReceived = blockSource.m_timeReceived;
         m_receivedFromIpv4 = blockSource.m_receivedFromIpv4;
         m_transactions = blockSource.m_transactions;
-        m_totalTransactions = 0;
+        m_totalTransactions = blockSource.m_totalTransactions;
+    }
+
+    Block::Block(Block &&blockSource) {
+        m_blockHeight = blockSource.m_blockHeight;
+        m_minerId = blockSource.m_minerId;
+        m_nonce = blockSource.m_nonce;
+        m_parentBlockMinerId = blockSource.m_parentBlockMinerId;
+        m_blockSizeBytes = blockSource.m_blockSizeBytes;
+        m_timeStamp = blockSource.m_timeStamp;
+        m_timeReceived = blockSource.m_timeReceived;
+        m_receivedFromIpv4 = blockSource.m_receivedFromIpv4;
+        m_transactions = std::move(blockSource.m_transactions);
+        m_totalTransactions = blockSource.m_totalTransactions;
+        blockSource.m_transactions = GetEmptyTransactions();
+        blockSource.m_totalTransactions = 0;
     }
 
     Block::~Block(void) {}
@@ -66,8 +85,16 @@ namespace ns3 {
         m_parentBlockMinerId = parentBlockMinerId;
     }
 
+    BlockId Block::GetBlockId(void) const {
+        return BlockId(m_blockHeight, m_minerId);
+    }
+
+    BlockId Block::GetParentBlockId(void) const {
+        return BlockId(m_blockHeight - 1, m_parentBlockMinerId);
+    }
+
     int Block::GetBlockSizeBytes(void) const {
-        return m_parentBlockMinerId;
+        return m_blockSizeBytes;
     }
 
     void Block::SetBlockSizeBytes(int blockSizeBytes) {
@@ -86,6 +113,10 @@ namespace ns3 {
         return m_timeReceived;
     }
 
+    void Block::SetTimeReceived(double timeReceived) {
+        m_timeReceived = timeReceived;
+    }
+
     Ipv4Address Block::GetReceivedFromIpv4(void) const {
         return m_receivedFromIpv4;
     }
@@ -94,17 +125,153 @@ namespace ns3 {
         m_receivedFromIpv4 = receivedFromIpv4;
     }
 
-    std::vector<Transaction> Block::GetTransactions(void) const {
-        return m_transactions;
+    const std::shared_ptr<Block::TransactionList>& Block::GetEmptyTransactions(void) {
+        static const std::shared_ptr<TransactionList> empty = std::make_shared<TransactionList>();
+        return empty;
+    }
+
+    Block::TransactionList& Block::MutableTransactions(void) {
+        if(m_transactions.use_count() > 1) {
+            std::shared_ptr<TransactionList> copy = std::make_shared<TransactionList>();
+            copy->transactions = m_transactions->transactions;
+            copy->readWriteSets = m_transactions->readWriteSets;
+            m_transactions = std::move(copy);
+        }
+        else {
+            m_transactions->index.clear();
+            m_transactions->merkleRootValid = false;
+        }
+        return *m_transactions;
+    }
+
+    const std::vector<Transaction>& Block::GetTransactions(void) const {
+        return m_transactions->transactions;
     }
 
     void Block::SetTransactions(const std::vector<Transaction> &transactions) {
-        m_transactions = transactions;
+        SetTransactions(std::vector<Transaction>(transactions));
+    }
+
+    void Block::SetTransactions(std::vector<Transaction> &&transactions) {
+        // Whatever arena the sets were built in, it is not this block's
+        for(auto &trans : transactions) {
+            trans.ClearReadWriteSet();
+        }
+        SetTransactions(std::move(transactions), ReadWriteArena());
+    }
+
+    void Block::SetTransactions(std::vector<Transaction> &&transactions, ReadWriteArena &&readWriteSets) {
+        std::shared_ptr<TransactionList> list = std::make_shared<TransactionList>();
+        list->transactions = std::move(transactions);
+        list->readWriteSets = std::move(readWriteSets);
+
+        // The sets were built in readWriteSets; only guard against a corrupt snapshot
+        for(auto &trans : list->transactions) {
+            if(!list->readWriteSets.Contains(trans.GetReadWriteSetOffset(), trans.GetReadCount() + trans.GetWriteCount())) {
+                trans.ClearReadWriteSet();
+            }
+        }
+        m_transactions = std::move(list);
+        m_totalTransactions = m_transactions->transactions.size();
+    }
+
+    static void WriteLE32(uint8_t *p, uint32_t x) {
+        p[0] = x;
+        p[1] = x >> 8;
+        p[2] = x >> 16;
+        p[3] = x >> 24;
+    }
+
+    static void WriteLE64(uint8_t *p, uint64_t x) {
+        WriteLE32(p, x);
+        WriteLE32(p + 4, x >> 32);
+    }
+
+    static uint64_t DoubleBits(double value) {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    static const size_t TRANSACTION_HASH_INPUT = 24;
+    static const size_t HEADER_HASH_INPUT = 60;
+
+    Hash256 Block::GetMerkleRoot(void) const {
+        TransactionList &list = *m_transactions;
+        if(list.merkleRootValid) {
+            return list.merkleRoot;
+        }
+
+        list.merkleRoot.fill(0);
+        size_t count = list.transactions.size();
+
+        if(count > 0) {
+            // Validation state is local to a node and is left out of the hash
+            std::vector<uint8_t> encoded(count * TRANSACTION_HASH_INPUT);
+            for(size_t i = 0; i < count; i++) {
+                const Transaction &trans = list.transactions[i];
+                uint8_t *p = &encoded[i * TRANSACTION_HASH_INPUT];
+
+                WriteLE32(p, trans.GetTransactionNodeId());
+                WriteLE32(p + 4, trans.GetTransactionId());
+                WriteLE32(p + 8, trans.GetTransSizeByte());
+                WriteLE32(p + 12, trans.GetExecution());
+                WriteLE64(p + 16, DoubleBits(trans.GetTransTimeStamp()));
+            }
+
+            // One spare hash so that an odd level can duplicate its last entry in place
+            std::vector<uint8_t> level((count + 1) * 32);
+            Sha256::DoubleHashShort(level.data(), encoded.data(), count, TRANSACTION_HASH_INPUT);
+
+            while(count > 1) {
+                if(count & 1) {
+                    std::memcpy(&level[count * 32], &level[(count - 1) * 32], 32);
+                    count++;
+                }
+                count /= 2;
+                Sha256::DoubleHash64(level.data(), level.data(), count);
+            }
+            std::memcpy(list.merkleRoot.data(), level.data(), 32);
+        }
+
+        list.merkleRootValid = true;
+        return list.merkleRoot;
+    }
+
+    Hash256 Block::GetHeaderHash(void) const {
+        uint8_t header[HEADER_HASH_INPUT];
+        Hash256 merkleRoot = GetMerkleRoot();
+        Hash256 hash;
+
+        WriteLE32(header, m_blockHeight);
+        WriteLE32(header + 4, m_minerId);
+        WriteLE32(header + 8, m_nonce);
+        WriteLE32(header + 12, m_parentBlockMinerId);
+        WriteLE32(header + 16, m_blockSizeBytes);
+        WriteLE64(header + 20, DoubleBits(m_timeStamp));
+        std::memcpy(header + 28, merkleRoot.data(), merkleRoot.size());
+
+        Sha256::DoubleHash(header, sizeof(header), hash);
+        return hash;
+    }
+
+    uint64_t Block::GetHashCompressions(void) const {
+        uint64_t count = m_transactions->transactions.size();
+        uint64_t compressions = Sha256::GetCompressions(HEADER_HASH_INPUT) + Sha256::GetCompressions(32);
+
+        if(count > 0) {
+            compressions += count * (Sha256::GetCompressions(TRANSACTION_HASH_INPUT) + Sha256::GetCompressions(32));
+        }
+        while(count > 1) {
+            count = (count + 1) / 2;
+            compressions += count * (Sha256::GetCompressions(64) + Sha256::GetCompressions(32));
+        }
+        return compressions;
     }
 
     bool Block::IsParent (const Block &block) const {
 
-        if(GetBlockHeight() == block.m_blockHeight - 1 && GetParentBlockMinerId() == block.GetParentBlockMinerId()) {
+        if(GetBlockHeight() == block.m_blockHeight - 1 && GetMinerId() == block.GetParentBlockMinerId()) {
             return true;
         } 
         return false;
@@ -113,7 +280,7 @@ namespace ns3 {
 
     bool Block::IsChild (const Block &block) const {
 
-        if(GetBlockHeight() == block.m_blockHeight + 1 && GetParentBlockMinerId() == block.GetParentBlockMinerId()) {
+        if(GetBlockHeight() == block.m_blockHeight + 1 && GetParentBlockMinerId() == block.GetMinerId()) {
             return true;
         }
         return false;
@@ -124,44 +291,114 @@ namespace ns3 {
         return m_totalTransactions;
     }
 
-    Transaction Block::ReturnTransaction(int nodeId, int transId) {
+    uint32_t Block::GetTransactionCount(void) const {
+        return m_transactions->transactions.size();
+    }
 
-        for(auto const &trans: m_transactions) {
-            if (trans.GetTransactionNodeId() == nodeId && trans.GetTransactionId() == transId) {
-                return trans;
+    const Transaction& Block::GetTransaction(uint32_t position) const {
+        return m_transactions->transactions[position];
+    }
+
+    uint32_t Block::FindTransaction(const TxId &id) const {
+        const std::vector<Transaction> &transactions = m_transactions->transactions;
+        std::vector<std::pair<TxId, uint32_t>> &index = m_transactions->index;
+        uint32_t count = transactions.size();
+
+        if(count < m_transactionIndexThreshold) {
+            for(uint32_t position = 0; position < count; position++) {
+                if(transactions[position].GetTxId() == id) {
+                    return position;
+                }
+            }
+            return count;
+        }
+
+        if(index.size() != count) {
+            index.clear();
+            index.reserve(count);
+            for(uint32_t position = 0; position < count; position++) {
+                index.push_back(std::make_pair(transactions[position].GetTxId(), position));
             }
+            std::sort(index.begin(), index.end());
         }
-        return Transaction();
+
+        auto it = std::lower_bound(index.begin(), index.end(), std::make_pair(id, static_cast<uint32_t>(0)));
+        return it != index.end() && it->first == id ? it->second : count;
+    }
+
+    Transaction Block::ReturnTransaction(int nodeId, int transId) {
+        uint32_t position = FindTransaction(TxId(nodeId, transId));
+        return position < GetTransactionCount() ? GetTransaction(position) : Transaction();
     }
 
 
     bool Block::HasTransaction(Transaction &newTrans) const {
-        for(auto const &trans: m_transactions) {
-            if (trans == newTrans) {
-                return true;
-            }
-        }
-        return false;
+        return FindTransaction(newTrans.GetTxId()) < GetTransactionCount();
     }
 
     bool Block::HasTransaction(int nodeId, int transId) const {
-        for(auto const &trans: m_transactions) {
-            if (trans.GetTransactionNodeId() == nodeId && trans.GetTransactionId() == transId) {
-                return true;
-            }
-        }
-        return false;
+        return FindTransaction(TxId(nodeId, transId)) < GetTransactionCount();
     }
 
     void Block::AddTransaction(const Transaction& newTrans) {
-        m_transactions.push_back(newTrans);
+        AddTransaction(newTrans, nullptr, 0, nullptr, 0);
+    }
+
+    void Block::AddTransaction(const Transaction& newTrans, const ReadWriteEntry *reads, uint16_t readCount,
+                               const ReadWriteEntry *writes, uint16_t writeCount) {
+        TransactionList &list = MutableTransactions();
+        Transaction trans = newTrans;
+        std::vector<ReadWriteEntry> copy;
+
+        // Sets taken from this block would move when the arena grows
+        if(list.readWriteSets.Owns(reads) || list.readWriteSets.Owns(writes)) {
+            copy.reserve(readCount + writeCount);
+            copy.insert(copy.end(), reads, reads + (reads ? readCount : 0));
+            copy.insert(copy.end(), writes, writes + (writes ? writeCount : 0));
+            reads = copy.data();
+            writes = copy.data() + readCount;
+        }
+
+        if(readCount + writeCount > 0) {
+            uint32_t offset = list.readWriteSets.Append(reads, readCount);
+            list.readWriteSets.Append(writes, writeCount);
+            trans.SetReadWriteSet(offset, readCount, writeCount);
+        }
+        else {
+            trans.ClearReadWriteSet();
+        }
+        list.transactions.push_back(trans);
         m_totalTransactions++;
     }
 
+    const ReadWriteEntry* Block::GetReads(uint32_t position) const {
+        return m_transactions->readWriteSets.Get(GetTransaction(position).GetReadWriteSetOffset());
+    }
+
+    const ReadWriteEntry* Block::GetWrites(uint32_t position) const {
+        const Transaction &trans = GetTransaction(position);
+        return m_transactions->readWriteSets.Get(trans.GetReadWriteSetOffset() + trans.GetReadCount());
+    }
+
+    uint32_t Block::GetReadWriteSetBytes(uint32_t position) const {
+        const Transaction &trans = GetTransaction(position);
+        const ReadWriteEntry *writes = GetWrites(position);
+        uint32_t bytes = trans.GetReadCount() * (sizeof(uint64_t) + sizeof(uint32_t));
+
+        for(int i = 0; i < trans.GetWriteCount(); i++) {
+            bytes += sizeof(uint64_t) + writes[i].valueSize;
+        }
+        return bytes;
+    }
+
+    const ReadWriteArena& Block::GetReadWriteSets(void) const {
+        return m_transactions->readWriteSets;
+    }
+
     void Block::PrintAllTransaction(void) {
-        if(m_transactions.size() != 0)
+        if(GetTransactionCount() != 0)
         {
-            for(auto const &tran: m_transactions)
+            for(auto const &tran: GetTransactions())
             {
                 std::cout << "[Blockheight: " <<m_blockHeight << "] Transaction nodeId: " 
                     << tran.GetTransactionNodeId() << " transId : " << tran.GetTransactionId() << "\n";
@@ -184,6 +421,26 @@ namespace ns3 {
         m_timeStamp = blockSource.m_timeStamp;
         m_timeReceived = blockSource.m_timeReceived;
         m_receivedFromIpv4 = blockSource.m_receivedFromIpv4;
+        m_transactions = blockSource.m_transactions;
+        m_totalTransactions = blockSource.m_totalTransactions;
+
+        return *this;
+    }
+
+    Block& Block::operator= (Block &&blockSource)
+    {
+        m_blockHeight = blockSource.m_blockHeight;
+        m_minerId = blockSource.m_minerId;
+        m_nonce = blockSource.m_nonce;
+        m_parentBlockMinerId = blockSource.m_parentBlockMinerId;
+        m_blockSizeBytes = blockSource.m_blockSizeBytes;
+        m_timeStamp = blockSource.m_timeStamp;
+        m_timeReceived = blockSource.m_timeReceived;
+        m_receivedFromIpv4 = blockSource.m_receivedFromIpv4;
+        m_transactions = std::move(blockSource.m_transactions);
+        m_totalTransactions = blockSource.m_totalTransactions;
+        blockSource.m_transactions = GetEmptyTransactions();
+        blockSource.m_totalTransactions = 0;
 
         return *this;
     }
@@ -1,10 +1,15 @@
 #ifndef BLOCK_H
 #define BLOCK_H
 
+#include <memory>
+#include <utility>
 #include <vector>
 #include "ns3/address.h"
 #include "ns3/inet-socket-address.h"
 
+#include "block-id.h"
+#include "read-write-set.h"
+#include "sha256.h"
 #include "transaction.h"
 #include "util.h"
 
@@ -15,6 +20,7 @@ namespace ns3 {
                 double timeStamp, double timeReceived, Ipv4Address receivedFromIpv4);
             Block();
             Block(const Block &blockSource);
+            Block(Block &&blockSource);
             virtual ~Block(void);
 
             int GetBlockHeight(void) const;
@@ -29,6 +35,10 @@ namespace ns3 {
             int GetParentBlockMinerId(void) const;
             void SetParentBlockMinerId(int parentBlockMinerId);
 
+            BlockId GetBlockId(void) const;
+            /* Id of the block this one extends: (height - 1, parentBlockMinerId) */
+            BlockId GetParentBlockId(void) const;
+
             int GetBlockSizeBytes(void) const;
             void SetBlockSizeBytes(int blockSizeBytes);
 
@@ -36,18 +46,49 @@ namespace ns3 {
             void SetTimeStamp(double timeStamp);
 
             double GetTimeReceived(void) const;
+            void SetTimeReceived(double timeReceived);
             
             Ipv4Address GetReceivedFromIpv4(void) const;
             void SetReceivedFromIpv4(Ipv4Address receivedFromIpv4); 
 
 
-            std::vector<Transaction> GetTransactions(void) const;
+            /*
+             * Copies of a block share one immutable transaction list; it is only
+             * copied when a block holding a shared list is modified.
+             */
+            const std::vector<Transaction>& GetTransactions(void) const;
             void SetTransactions(const std::vector<Transaction> &transactions);
+            void SetTransactions(std::vector<Transaction> &&transactions);
+            /*
+             * Takes transactions together with the arena their read/write sets were
+             * built in, as when a block is decoded or restored. The single argument
+             * versions always drop the read/write sets; use AddTransaction to carry
+             * sets over from another block.
+             */
+            void SetTransactions(std::vector<Transaction> &&transactions, ReadWriteArena &&readWriteSets);
+
+            /*
+             * Bitcoin-style Merkle root: the SHA-256d of every transaction, paired
+             * level by level (the last hash of an odd level is paired with itself).
+             * Computed once and cached with the transaction list, so copies hash it once.
+             */
+            Hash256 GetMerkleRoot(void) const;
+            /* SHA-256d of the header fields and the Merkle root */
+            Hash256 GetHeaderHash(void) const;
+            /* SHA-256 compressions needed to hash the header and the Merkle tree, for validation cost models */
+            uint64_t GetHashCompressions(void) const;
 
             bool IsParent (const Block &block) const;
             bool IsChild (const Block &block) const;
 
             int GetTotalTransaction(void) const;
+            uint32_t GetTransactionCount(void) const;
+            const Transaction& GetTransaction(uint32_t position) const;
+            /*
+             * Position of the transaction, GetTransactionCount() if the block does
+             * not hold it. Large blocks build a sorted id index on the first lookup.
+             */
+            uint32_t FindTransaction(const TxId &id) const;
 
             Transaction ReturnTransaction(int nodeId, int transId);
 
@@ -55,10 +96,21 @@ namespace ns3 {
             bool HasTransaction(int nodeId, int tranId) const;
 
             void AddTransaction(const Transaction& newTrans);
+            /* Adds the transaction with its reads and writes copied into the block's arena */
+            void AddTransaction(const Transaction& newTrans, const ReadWriteEntry *reads, uint16_t readCount,
+                                const ReadWriteEntry *writes, uint16_t writeCount);
+
+            /* Read and write sets of the transaction at position, valid until the block is modified */
+            const ReadWriteEntry* GetReads(uint32_t position) const;
+            const ReadWriteEntry* GetWrites(uint32_t position) const;
+            /* Size of the read/write set in an endorsement: key and version per read, key and value per write */
+            uint32_t GetReadWriteSetBytes(uint32_t position) const;
+            const ReadWriteArena& GetReadWriteSets(void) const;
 
             void PrintAllTransaction(void);
 
             Block& operator = (const Block &blockSource);
+            Block& operator = (Block &&blockSource);
             friend bool operator == (const Block &block1, const Block &block2);
 
         protected:
@@ -72,7 +124,25 @@ namespace ns3 {
             double m_timeReceived;
 
             Ipv4Address m_receivedFromIpv4;
-            std::vector<Transaction> m_transactions;
+
+            /* The transactions and what is derived from them, shared between copies */
+            struct TransactionList {
+                std::vector<Transaction> transactions;
+                ReadWriteArena readWriteSets;
+                std::vector<std::pair<TxId, uint32_t>> index;   // sorted by id, empty until needed
+                Hash256 merkleRoot;
+                bool merkleRootValid;
+
+                TransactionList(void) : merkleRootValid(false) {}
+            };
+
+            /* The list, copied first if other blocks share it; the cached index and root are dropped */
+            TransactionList& MutableTransactions(void);
+            /* One empty list shared by every block without transactions */
+            static const std::shared_ptr<TransactionList>& GetEmptyTransactions(void);
+
+            static const uint32_t m_transactionIndexThreshold = 32;    // smaller blocks are scanned
+            std::shared_ptr<TransactionList> m_transactions;    // never null
     };
 }
 
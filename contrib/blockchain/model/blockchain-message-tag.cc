@@ -0,0 +1,60 @@
+#include "ns3/log.h"
+
+#include "blockchain-message-tag.h"
+
+namespace ns3 {
+    NS_OBJECT_ENSURE_REGISTERED(BlockchainMessageTag);
+
+    TypeId BlockchainMessageTag::GetTypeId(void) {
+        static TypeId tid = TypeId("ns3::BlockchainMessageTag")
+        .SetParent<Tag>()
+        .SetGroupName("Applications")
+        .AddConstructor<BlockchainMessageTag>();
+
+        return tid;
+    }
+
+    TypeId BlockchainMessageTag::GetInstanceTypeId(void) const {
+        return GetTypeId();
+    }
+
+    BlockchainMessageTag::BlockchainMessageTag(void) : m_frame(&m_storage) {}
+
+    BlockchainMessageTag::BlockchainMessageTag(std::string &frame) : m_frame(&frame) {}
+
+    BlockchainMessageTag::BlockchainMessageTag(const BlockchainMessageTag &tag)
+        : Tag(tag), m_storage(tag.m_storage), m_frame(tag.m_frame == &tag.m_storage ? &m_storage : tag.m_frame) {}
+
+    BlockchainMessageTag::~BlockchainMessageTag(void) {}
+
+    BlockchainMessageTag& BlockchainMessageTag::operator = (const BlockchainMessageTag &tag) {
+        if(this != &tag) {
+            m_storage = tag.m_storage;
+            m_frame = tag.m_frame == &tag.m_storage ? &m_storage : tag.m_frame;
+        }
+        return *this;
+    }
+
+    uint32_t BlockchainMessageTag::GetSerializedSize(void) const {
+        return sizeof(uint32_t) + m_frame->size();
+    }
+
+    void BlockchainMessageTag::Serialize(TagBuffer i) const {
+        i.WriteU32(m_frame->size());
+        i.Write(reinterpret_cast<const uint8_t *>(m_frame->data()), m_frame->size());
+    }
+
+    void BlockchainMessageTag::Deserialize(TagBuffer i) {
+        // Resizing keeps the capacity of a reused buffer
+        m_frame->resize(i.ReadU32());
+        i.Read(reinterpret_cast<uint8_t *>(&(*m_frame)[0]), m_frame->size());
+    }
+
+    void BlockchainMessageTag::Print(std::ostream &os) const {
+        os << "frame=" << m_frame->size() << " bytes";
+    }
+
+    const std::string &BlockchainMessageTag::GetFrame(void) const {
+        return *m_frame;
+    }
+}
@@ -0,0 +1,43 @@
+#ifndef BLOCKCHAIN_MESSAGE_TAG_H
+#define BLOCKCHAIN_MESSAGE_TAG_H
+
+#include <ostream>
+#include <string>
+#include "ns3/tag.h"
+
+namespace ns3 {
+    /*
+     * Carries a message, in its binary encoding, as a byte tag on a packet
+     * whose payload is only virtual (zero-filled) bytes of the modelled size.
+     *
+     * A tag bound to a frame buffer serializes from it and deserializes into
+     * it, so a caller's reused buffers are the only copy of the frame outside
+     * the packet. A default constructed tag keeps the frame itself.
+     */
+    class BlockchainMessageTag : public Tag {
+        public:
+            static TypeId GetTypeId(void);
+            virtual TypeId GetInstanceTypeId(void) const;
+
+            BlockchainMessageTag(void);
+            BlockchainMessageTag(std::string &frame);
+            BlockchainMessageTag(const BlockchainMessageTag &tag);
+            virtual ~BlockchainMessageTag(void);
+
+            BlockchainMessageTag& operator = (const BlockchainMessageTag &tag);
+
+            virtual uint32_t GetSerializedSize(void) const;
+            virtual void Serialize(TagBuffer i) const;
+            virtual void Deserialize(TagBuffer i);
+            virtual void Print(std::ostream &os) const;
+
+            /* The binary frame of the message, as encoded by MessageCodec */
+            const std::string &GetFrame(void) const;
+
+        protected:
+            std::string m_storage;  // frame of a tag not bound to a buffer
+            std::string *m_frame;   // binary frame of the message
+    };
+}
+
+#endif
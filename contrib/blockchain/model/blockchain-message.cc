@@ -0,0 +1,710 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "blockchain-message.h"
+#include "blockchain.h"
+#include "../../../rapidjson/document.h"
+#include "../../../rapidjson/writer.h"
+#include "../../../rapidjson/stringbuffer.h"
+
+namespace ns3 {
+
+    static const size_t FRAME_LENGTH_BYTES = 4;
+    static const size_t BLOCK_ID_BYTES = 8;
+    static const size_t TRANSACTION_BYTES = 25;
+    static const size_t BLOCK_BYTES = 5 * 4 + 2 * 8 + 4 + 4 + 4;
+    static const size_t READ_WRITE_SET_BYTES = 4 + 2 + 2;
+    static const size_t READ_WRITE_ENTRY_BYTES = 8 + 4 + 4;
+
+    static bool HasBlockIds(enum Messages type) {
+        return type == INV || type == GET_HEADERS || type == GET_DATA;
+    }
+
+    static bool HasBlocks(enum Messages type) {
+        return type == HEADERS || type == BLOCK;
+    }
+
+    static bool HasTransactions(enum Messages type) {
+        return type == REQUEST_TRANS || type == REPLY_TRANS || type == MSG_TRANS || type == RESULT_TRANS;
+    }
+
+    /* Name of the JSON array holding the block ids, as sent by earlier versions */
+    static const char* GetBlockIdsName(enum Messages type) {
+        return type == INV ? "inv" : "blocks";
+    }
+
+    std::ostream& operator << (std::ostream &os, const BlockchainMessage &message) {
+        os << GetMessageName(message.type);
+        if(HasBlockIds(message.type)) {
+            os << " blocks";
+            for(auto const &id : message.blockIds) {
+                os << " " << id;
+            }
+        }
+        if(HasBlocks(message.type)) {
+            os << " blocks";
+            for(auto const &block : message.blocks) {
+                os << " " << block.GetBlockId() << " (" << block.GetTransactionCount() << " transactions)";
+            }
+        }
+        if(HasTransactions(message.type)) {
+            os << " transactions";
+            for(auto const &trans : message.transactions) {
+                os << " " << trans.GetTxId();
+            }
+        }
+        return os;
+    }
+
+    class BinaryWriter {
+        public:
+            BinaryWriter(std::string &out) : m_out(out) {}
+
+            void WriteU8(uint8_t value) {
+                m_out.push_back(static_cast<char>(value));
+            }
+
+            void WriteU16(uint16_t value) {
+                char bytes[2] = {static_cast<char>(value), static_cast<char>(value >> 8)};
+                m_out.append(bytes, sizeof(bytes));
+            }
+
+            void WriteU32(uint32_t value) {
+                char bytes[4] = {static_cast<char>(value), static_cast<char>(value >> 8),
+                                 static_cast<char>(value >> 16), static_cast<char>(value >> 24)};
+                m_out.append(bytes, sizeof(bytes));
+            }
+
+            void WriteU64(uint64_t value) {
+                WriteU32(value);
+                WriteU32(value >> 32);
+            }
+
+            void WriteDouble(double value) {
+                uint64_t bits;
+                std::memcpy(&bits, &value, sizeof(bits));
+                WriteU64(bits);
+            }
+
+            void WriteTransaction(const Transaction &trans) {
+                WriteU32(trans.GetTransactionNodeId());
+                WriteU32(trans.GetTransactionId());
+                WriteDouble(trans.GetTransTimeStamp());
+                WriteU32(trans.GetTransSizeByte());
+                WriteU32(trans.GetExecution());
+                WriteU8(trans.IsValidated() ? 1 : 0);
+            }
+
+            /* The transactions holding a set, by position, each followed by its reads then its writes */
+            void WriteReadWriteSets(const Block &block) {
+                uint32_t sets = 0;
+
+                for(auto const &trans : block.GetTransactions()) {
+                    sets += trans.HasReadWriteSet() ? 1 : 0;
+                }
+                WriteU32(sets);
+                for(uint32_t i = 0; i < block.GetTransactionCount(); i++) {
+                    const Transaction &trans = block.GetTransaction(i);
+                    if(!trans.HasReadWriteSet()) continue;
+
+                    const ReadWriteEntry *entries = block.GetReads(i);
+                    WriteU32(i);
+                    WriteU16(trans.GetReadCount());
+                    WriteU16(trans.GetWriteCount());
+                    for(int j = 0; j < trans.GetReadCount() + trans.GetWriteCount(); j++) {
+                        WriteU64(entries[j].key);
+                        WriteU32(entries[j].version);
+                        WriteU32(entries[j].valueSize);
+                    }
+                }
+            }
+
+        private:
+            std::string &m_out;
+    };
+
+    /* Bounds checked reads; once a read runs past the end every later read fails */
+    class BinaryReader {
+        public:
+            BinaryReader(const char *data, size_t size) : m_data(reinterpret_cast<const uint8_t *>(data)), m_left(size), m_good(true) {}
+
+            uint8_t ReadU8(void) {
+                if(!Take(1)) {
+                    return 0;
+                }
+                return m_data[-1];
+            }
+
+            uint16_t ReadU16(void) {
+                if(!Take(2)) {
+                    return 0;
+                }
+                const uint8_t *p = m_data - 2;
+                return p[0] | (p[1] << 8);
+            }
+
+            uint32_t ReadU32(void) {
+                if(!Take(4)) {
+                    return 0;
+                }
+                const uint8_t *p = m_data - 4;
+                return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+            }
+
+            uint64_t ReadU64(void) {
+                uint64_t low = ReadU32();
+                return low | (static_cast<uint64_t>(ReadU32()) << 32);
+            }
+
+            double ReadDouble(void) {
+                uint64_t bits = ReadU64();
+                double value;
+                std::memcpy(&value, &bits, sizeof(value));
+                return value;
+            }
+
+            Transaction ReadTransaction(void) {
+                int nodeId = ReadU32();
+                int transId = ReadU32();
+                Transaction trans(nodeId, transId, ReadDouble());
+
+                trans.SetTransSizeByte(ReadU32());
+                trans.SetExecution(ReadU32());
+                if(ReadU8()) {
+                    trans.SetValidation();
+                }
+                return trans;
+            }
+
+            /* Reads the sets written by WriteReadWriteSets into an empty arena */
+            void ReadReadWriteSets(std::vector<Transaction> &transactions, ReadWriteArena &readWriteSets) {
+                uint32_t sets = ReadCount(READ_WRITE_SET_BYTES);
+                uint32_t next = 0;
+
+                for(uint32_t i = 0; i < sets && m_good; i++) {
+                    uint32_t position = ReadU32();
+                    uint16_t readCount = ReadU16();
+                    uint16_t writeCount = ReadU16();
+                    uint32_t count = readCount + writeCount;
+
+                    // One set per transaction, in order, and entries that are really there
+                    if(position < next || position >= transactions.size() || count == 0
+                       || count > m_left / READ_WRITE_ENTRY_BYTES) {
+                        m_good = false;
+                        return;
+                    }
+                    next = position + 1;
+
+                    uint32_t offset = readWriteSets.Allocate(count);
+                    ReadWriteEntry *entries = readWriteSets.Get(offset);
+                    for(uint32_t j = 0; j < count; j++) {
+                        entries[j].key = ReadU64();
+                        entries[j].version = ReadU32();
+                        entries[j].valueSize = ReadU32();
+                    }
+                    transactions[position].SetReadWriteSet(offset, readCount, writeCount);
+                }
+            }
+
+            /* Reads a count of records of recordSize bytes, failing if they cannot fit in what is left */
+            uint32_t ReadCount(size_t recordSize) {
+                uint32_t count = ReadU32();
+                if(count > m_left / recordSize) {
+                    m_good = false;
+                    return 0;
+                }
+                return count;
+            }
+
+            bool IsGood(void) const { return m_good; }
+            bool AtEnd(void) const { return m_left == 0; }
+
+        private:
+            bool Take(size_t size) {
+                if(!m_good || m_left < size) {
+                    m_good = false;
+                    return false;
+                }
+                m_data += size;
+                m_left -= size;
+                return true;
+            }
+
+            const uint8_t *m_data;
+            size_t m_left;
+            bool m_good;
+    };
+
+    /*
+     * Values are allocated from a preallocated chunk, and the parse stack from
+     * a second one; both are reset before each message. The parse stack has to
+     * be pooled as well, as the document frees it after every parse.
+     */
+    struct MessageCodec::JsonState {
+        typedef rapidjson::MemoryPoolAllocator<> Pool;
+        typedef rapidjson::GenericDocument<rapidjson::UTF8<>, Pool, Pool> Document;
+
+        static const size_t STACK_BYTES = 4 * 1024;
+
+        std::vector<char> valueChunk;
+        std::vector<char> stackChunk;
+        Pool valueAllocator;
+        Pool stackAllocator;
+        Document document;
+        rapidjson::StringBuffer buffer;
+        rapidjson::Writer<rapidjson::StringBuffer> writer;
+
+        JsonState(void)
+            : valueChunk(JSON_POOL_BYTES), stackChunk(STACK_BYTES),
+              valueAllocator(valueChunk.data(), valueChunk.size()),
+              stackAllocator(stackChunk.data(), stackChunk.size()),
+              document(&valueAllocator, STACK_BYTES / 4, &stackAllocator),
+              writer(buffer) {}
+    };
+
+    MessageCodec::MessageCodec(enum WireFormat format) : m_format(format) {}
+
+    MessageCodec::~MessageCodec(void) {}
+
+    enum WireFormat MessageCodec::GetFormat(void) const {
+        return m_format;
+    }
+
+    void MessageCodec::SetFormat(enum WireFormat format) {
+        m_format = format;
+    }
+
+    MessageCodec::JsonState& MessageCodec::GetJsonState(void) {
+        if(!m_json) {
+            m_json.reset(new JsonState());
+        }
+        return *m_json;
+    }
+
+    void MessageCodec::Encode(const BlockchainMessage &message, std::string &frame) {
+        if(m_format == BINARY_FORMAT) {
+            EncodeBinary(message, frame);
+        }
+        else {
+            EncodeJson(message, frame);
+        }
+    }
+
+    void MessageCodec::EncodeBinary(const BlockchainMessage &message, std::string &frame) {
+        BinaryWriter writer(frame);
+        size_t start = frame.size();
+
+        // Length placeholder, filled in once the payload is written
+        writer.WriteU32(0);
+        writer.WriteU8(message.type);
+
+        if(HasBlockIds(message.type)) {
+            writer.WriteU32(message.blockIds.size());
+            for(auto const &id : message.blockIds) {
+                writer.WriteU64(id.GetPacked());
+            }
+        }
+        else if(HasBlocks(message.type)) {
+            writer.WriteU32(message.blocks.size());
+            for(auto const &block : message.blocks) {
+                writer.WriteU32(block.GetBlockHeight());
+                writer.WriteU32(block.GetMinerId());
+                writer.WriteU32(block.GetNonce());
+                writer.WriteU32(block.GetParentBlockMinerId());
+                writer.WriteU32(block.GetBlockSizeBytes());
+                writer.WriteDouble(block.GetTimeStamp());
+                writer.WriteDouble(block.GetTimeReceived());
+                writer.WriteU32(block.GetReceivedFromIpv4().Get());
+                writer.WriteU32(block.GetTransactionCount());
+                for(auto const &trans : block.GetTransactions()) {
+                    writer.WriteTransaction(trans);
+                }
+                writer.WriteReadWriteSets(block);
+            }
+        }
+        else if(HasTransactions(message.type)) {
+            writer.WriteU32(message.transactions.size());
+            for(auto const &trans : message.transactions) {
+                writer.WriteTransaction(trans);
+            }
+        }
+
+        uint32_t payloadSize = frame.size() - start - FRAME_LENGTH_BYTES;
+        for(size_t i = 0; i < FRAME_LENGTH_BYTES; i++) {
+            frame[start + i] = static_cast<char>(payloadSize >> (8 * i));
+        }
+    }
+
+    template <typename Writer>
+    static void WriteJsonReadWriteEntries(Writer &writer, const ReadWriteEntry *entries, int count, bool withValueSize) {
+        writer.StartArray();
+        for(int i = 0; i < count; i++) {
+            writer.StartArray();
+            writer.Uint64(entries[i].key);
+            writer.Uint(entries[i].version);
+            if(withValueSize) {
+                writer.Uint(entries[i].valueSize);
+            }
+            writer.EndArray();
+        }
+        writer.EndArray();
+    }
+
+    /* The read/write sets are written when the transactions are those of block */
+    template <typename Writer>
+    static void WriteJsonTransactions(Writer &writer, const std::vector<Transaction> &transactions, const Block *block = nullptr) {
+        writer.StartArray();
+        for(uint32_t i = 0; i < transactions.size(); i++) {
+            const Transaction &trans = transactions[i];
+
+            writer.StartObject();
+            writer.Key("nodeId");
+            writer.Int(trans.GetTransactionNodeId());
+            writer.Key("transId");
+            writer.Int(trans.GetTransactionId());
+            writer.Key("timestamp");
+            writer.Double(trans.GetTransTimeStamp());
+            writer.Key("size");
+            writer.Int(trans.GetTransSizeByte());
+            writer.Key("validation");
+            writer.Bool(trans.IsValidated());
+            writer.Key("execution");
+            writer.Int(trans.GetExecution());
+            if(block != nullptr && trans.HasReadWriteSet()) {
+                // [key, version] per read, [key, version, value size] per write
+                writer.Key("reads");
+                WriteJsonReadWriteEntries(writer, block->GetReads(i), trans.GetReadCount(), false);
+                writer.Key("writes");
+                WriteJsonReadWriteEntries(writer, block->GetWrites(i), trans.GetWriteCount(), true);
+            }
+            writer.EndObject();
+        }
+        writer.EndArray();
+    }
+
+    void MessageCodec::EncodeJson(const BlockchainMessage &message, std::string &frame) {
+        JsonState &json = GetJsonState();
+        rapidjson::Writer<rapidjson::StringBuffer> &writer = json.writer;
+
+        json.buffer.Clear();
+        writer.Reset(json.buffer);
+
+        writer.StartObject();
+        writer.Key("type");
+        writer.String(HasTransactions(message.type) ? "transactions" : "blocks");
+        writer.Key("message");
+        writer.Int(message.type);
+
+        if(HasBlockIds(message.type)) {
+            writer.Key(GetBlockIdsName(message.type));
+            writer.StartArray();
+            for(auto const &id : message.blockIds) {
+                char blockHash[24];
+                int length = std::snprintf(blockHash, sizeof(blockHash), "%d/%d", id.GetHeight(), id.GetMinerId());
+                writer.String(blockHash, length);
+            }
+            writer.EndArray();
+        }
+        else if(HasBlocks(message.type)) {
+            writer.Key("blocks");
+            writer.StartArray();
+            for(auto const &block : message.blocks) {
+                writer.StartObject();
+                writer.Key("height");
+                writer.Int(block.GetBlockHeight());
+                writer.Key("minerId");
+                writer.Int(block.GetMinerId());
+                writer.Key("nonce");
+                writer.Int(block.GetNonce());
+                writer.Key("parentBlockMinerId");
+                writer.Int(block.GetParentBlockMinerId());
+                writer.Key("size");
+                writer.Int(block.GetBlockSizeBytes());
+                writer.Key("timeCreated");
+                writer.Double(block.GetTimeStamp());
+                writer.Key("timeReceived");
+                writer.Double(block.GetTimeReceived());
+                writer.Key("receivedFromIpv4");
+                writer.Uint(block.GetReceivedFromIpv4().Get());
+                writer.Key("transactions");
+                WriteJsonTransactions(writer, block.GetTransactions(), &block);
+                writer.EndObject();
+            }
+            writer.EndArray();
+        }
+        else if(HasTransactions(message.type)) {
+            writer.Key("transactions");
+            WriteJsonTransactions(writer, message.transactions);
+        }
+        writer.EndObject();
+
+        frame.append(json.buffer.GetString(), json.buffer.GetSize());
+        frame.push_back(JSON_DELIMITER);
+    }
+
+    size_t MessageCodec::FindFrame(const char *data, size_t size, size_t &payloadOffset, size_t &payloadSize, bool &corrupt) const {
+        size_t scanned = 0;
+
+        return FindFrame(data, size, scanned, payloadOffset, payloadSize, corrupt);
+    }
+
+    size_t MessageCodec::FindFrame(const char *data, size_t size, size_t &scanned, size_t &payloadOffset, size_t &payloadSize, bool &corrupt) const {
+        corrupt = false;
+        if(m_format == BINARY_FORMAT) {
+            if(size < FRAME_LENGTH_BYTES) {
+                return 0;
+            }
+            const uint8_t *p = reinterpret_cast<const uint8_t *>(data);
+            uint32_t length = p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+
+            if(length > MAX_FRAME_BYTES) {
+                corrupt = true;
+                return 0;
+            }
+            if(size - FRAME_LENGTH_BYTES < length) {
+                return 0;
+            }
+            payloadOffset = FRAME_LENGTH_BYTES;
+            payloadSize = length;
+            return FRAME_LENGTH_BYTES + length;
+        }
+
+        size_t from = std::min(scanned, size);
+        const char *end = static_cast<const char *>(std::memchr(data + from, JSON_DELIMITER, size - from));
+        if(end == nullptr) {
+            scanned = size;
+            corrupt = size > MAX_FRAME_BYTES;
+            return 0;
+        }
+        if(static_cast<size_t>(end - data) > MAX_FRAME_BYTES) {
+            corrupt = true;
+            return 0;
+        }
+        payloadOffset = 0;
+        payloadSize = end - data;
+        return payloadSize + 1;
+    }
+
+    bool MessageCodec::Decode(char *payload, size_t size, BlockchainMessage &message) {
+        message.blockIds.clear();
+        message.blocks.clear();
+        message.transactions.clear();
+
+        if(m_format == BINARY_FORMAT) {
+            return DecodeBinary(payload, size, message);
+        }
+        return DecodeJson(payload, size, message);
+    }
+
+    bool MessageCodec::DecodeBinary(const char *payload, size_t size, BlockchainMessage &message) {
+        BinaryReader reader(payload, size);
+        uint8_t type = reader.ReadU8();
+
+        if(!reader.IsGood() || type > RESULT_TRANS) {
+            return false;
+        }
+        message.type = static_cast<enum Messages>(type);
+
+        if(HasBlockIds(message.type)) {
+            uint32_t count = reader.ReadCount(BLOCK_ID_BYTES);
+            message.blockIds.reserve(count);
+            for(uint32_t i = 0; i < count; i++) {
+                uint64_t packed = reader.ReadU64();
+                message.blockIds.push_back(BlockId(packed >> 32, packed & 0xffffffff));
+            }
+        }
+        else if(HasBlocks(message.type)) {
+            uint32_t count = reader.ReadCount(BLOCK_BYTES);
+            message.blocks.reserve(count);
+            for(uint32_t i = 0; i < count && reader.IsGood(); i++) {
+                int height = reader.ReadU32();
+                int minerId = reader.ReadU32();
+                int nonce = reader.ReadU32();
+                int parentBlockMinerId = reader.ReadU32();
+                int blockSizeBytes = reader.ReadU32();
+                double timeStamp = reader.ReadDouble();
+                double timeReceived = reader.ReadDouble();
+                Ipv4Address receivedFromIpv4(reader.ReadU32());
+                uint32_t transactionCount = reader.ReadCount(TRANSACTION_BYTES);
+                std::vector<Transaction> transactions;
+                ReadWriteArena readWriteSets;
+
+                transactions.reserve(transactionCount);
+                for(uint32_t j = 0; j < transactionCount; j++) {
+                    transactions.push_back(reader.ReadTransaction());
+                }
+                reader.ReadReadWriteSets(transactions, readWriteSets);
+                message.blocks.push_back(Block(height, minerId, nonce, parentBlockMinerId, blockSizeBytes,
+                                               timeStamp, timeReceived, receivedFromIpv4));
+                message.blocks.back().SetTransactions(std::move(transactions), std::move(readWriteSets));
+            }
+        }
+        else if(HasTransactions(message.type)) {
+            uint32_t count = reader.ReadCount(TRANSACTION_BYTES);
+            message.transactions.reserve(count);
+            for(uint32_t i = 0; i < count; i++) {
+                message.transactions.push_back(reader.ReadTransaction());
+            }
+        }
+        return reader.IsGood() && reader.AtEnd();
+    }
+
+    static bool DecodeJsonTransaction(const rapidjson::Value &value, Transaction &trans) {
+        if(!value.IsObject() || !value.HasMember("nodeId") || !value["nodeId"].IsInt()
+           || !value.HasMember("transId") || !value["transId"].IsInt()
+           || !value.HasMember("timestamp") || !value["timestamp"].IsNumber()) {
+            return false;
+        }
+
+        trans = Transaction(value["nodeId"].GetInt(), value["transId"].GetInt(), value["timestamp"].GetDouble());
+        if(value.HasMember("size") && value["size"].IsInt()) {
+            trans.SetTransSizeByte(value["size"].GetInt());
+        }
+        if(value.HasMember("execution") && value["execution"].IsInt()) {
+            trans.SetExecution(value["execution"].GetInt());
+        }
+        if(value.HasMember("validation") && value["validation"].IsBool() && value["validation"].GetBool()) {
+            trans.SetValidation();
+        }
+        return true;
+    }
+
+    static bool DecodeJsonReadWriteEntries(const rapidjson::Value &value, const char *name, bool withValueSize,
+                                           ReadWriteArena &readWriteSets, uint16_t &count) {
+        if(!value.HasMember(name)) {
+            count = 0;
+            return true;
+        }
+
+        const rapidjson::Value &array = value[name];
+        if(!array.IsArray() || array.Size() > UINT16_MAX) {
+            return false;
+        }
+        count = array.Size();
+
+        uint32_t offset = readWriteSets.Allocate(count);
+        ReadWriteEntry *entries = readWriteSets.Get(offset);
+        for(rapidjson::SizeType i = 0; i < array.Size(); i++) {
+            const rapidjson::Value &entry = array[i];
+            if(!entry.IsArray() || entry.Size() != (withValueSize ? 3u : 2u) || !entry[0].IsUint64() || !entry[1].IsUint()
+               || (withValueSize && !entry[2].IsUint())) {
+                return false;
+            }
+            entries[i].key = entry[0].GetUint64();
+            entries[i].version = entry[1].GetUint();
+            entries[i].valueSize = withValueSize ? entry[2].GetUint() : 0;
+        }
+        return true;
+    }
+
+    /* Sets are only read when readWriteSets is given, for the transactions of a block */
+    static bool DecodeJsonTransactions(const rapidjson::Value &array, std::vector<Transaction> &transactions,
+                                       ReadWriteArena *readWriteSets = nullptr) {
+        if(!array.IsArray()) {
+            return false;
+        }
+
+        transactions.reserve(array.Size());
+        for(rapidjson::SizeType i = 0; i < array.Size(); i++) {
+            Transaction trans;
+            if(!DecodeJsonTransaction(array[i], trans)) {
+                return false;
+            }
+            if(readWriteSets != nullptr) {
+                uint32_t offset = readWriteSets->GetSize();
+                uint16_t readCount;
+                uint16_t writeCount;
+
+                if(!DecodeJsonReadWriteEntries(array[i], "reads", false, *readWriteSets, readCount)
+                   || !DecodeJsonReadWriteEntries(array[i], "writes", true, *readWriteSets, writeCount)) {
+                    return false;
+                }
+                trans.SetReadWriteSet(offset, readCount, writeCount);
+            }
+            transactions.push_back(trans);
+        }
+        return true;
+    }
+
+    static int GetJsonInt(const rapidjson::Value &value, const char *name) {
+        return value.HasMember(name) && value[name].IsInt() ? value[name].GetInt() : 0;
+    }
+
+    static double GetJsonDouble(const rapidjson::Value &value, const char *name) {
+        return value.HasMember(name) && value[name].IsNumber() ? value[name].GetDouble() : 0;
+    }
+
+    bool MessageCodec::DecodeJson(char *payload, size_t size, BlockchainMessage &message) {
+        JsonState &json = GetJsonState();
+        JsonState::Document &document = json.document;
+
+        // The delimiter becomes the terminator, strings are unescaped in place
+        payload[size] = '\0';
+        document.SetNull();
+        json.valueAllocator.Clear();
+        json.stackAllocator.Clear();
+        document.ParseInsitu(payload);
+        if(document.HasParseError() || !document.IsObject() || !document.HasMember("message") || !document["message"].IsInt()) {
+            return false;
+        }
+
+        int type = document["message"].GetInt();
+        if(type < INV || type > RESULT_TRANS) {
+            return false;
+        }
+        message.type = static_cast<enum Messages>(type);
+
+        if(HasBlockIds(message.type)) {
+            const char *name = GetBlockIdsName(message.type);
+            if(!document.HasMember(name) || !document[name].IsArray()) {
+                return false;
+            }
+
+            const rapidjson::Value &array = document[name];
+            message.blockIds.reserve(array.Size());
+            for(rapidjson::SizeType i = 0; i < array.Size(); i++) {
+                BlockId id;
+                if(!array[i].IsString() || !BlockId::FromString(array[i].GetString(), id)) {
+                    return false;
+                }
+                message.blockIds.push_back(id);
+            }
+        }
+        else if(HasBlocks(message.type)) {
+            if(!document.HasMember("blocks") || !document["blocks"].IsArray()) {
+                return false;
+            }
+
+            const rapidjson::Value &array = document["blocks"];
+            message.blocks.reserve(array.Size());
+            for(rapidjson::SizeType i = 0; i < array.Size(); i++) {
+                const rapidjson::Value &value = array[i];
+                std::vector<Transaction> transactions;
+                ReadWriteArena readWriteSets;
+
+                if(!value.IsObject() || !value.HasMember("height") || !value["height"].IsInt()
+                   || !value.HasMember("minerId") || !value["minerId"].IsInt()) {
+                    return false;
+                }
+                if(value.HasMember("transactions") && !DecodeJsonTransactions(value["transactions"], transactions, &readWriteSets)) {
+                    return false;
+                }
+
+                uint32_t receivedFromIpv4 = value.HasMember("receivedFromIpv4") && value["receivedFromIpv4"].IsUint()
+                                            ? value["receivedFromIpv4"].GetUint() : 0;
+                message.blocks.push_back(Block(value["height"].GetInt(), value["minerId"].GetInt(), GetJsonInt(value, "nonce"),
+                                               GetJsonInt(value, "parentBlockMinerId"), GetJsonInt(value, "size"),
+                                               GetJsonDouble(value, "timeCreated"), GetJsonDouble(value, "timeReceived"),
+                                               Ipv4Address(receivedFromIpv4)));
+                message.blocks.back().SetTransactions(std::move(transactions), std::move(readWriteSets));
+            }
+        }
+        else if(HasTransactions(message.type)) {
+            if(!document.HasMember("transactions") || !DecodeJsonTransactions(document["transactions"], message.transactions)) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
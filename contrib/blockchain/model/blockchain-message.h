@@ -0,0 +1,101 @@
+#ifndef BLOCKCHAIN_MESSAGE_H
+#define BLOCKCHAIN_MESSAGE_H
+
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "block.h"
+#include "block-id.h"
+#include "transaction.h"
+#include "util.h"
+
+namespace ns3 {
+    /*
+     * A message exchanged by BlockchainNodes. Only the list that belongs to the
+     * type is carried: block ids for INV, GET_HEADERS and GET_DATA, blocks for
+     * HEADERS and BLOCK, transactions for the *_TRANS messages.
+     */
+    struct BlockchainMessage {
+        enum Messages type;
+        std::vector<BlockId> blockIds;
+        std::vector<Block> blocks;
+        std::vector<Transaction> transactions;
+
+        BlockchainMessage(enum Messages messageType = NO_MESSAGE) : type(messageType) {}
+    };
+
+    std::ostream& operator << (std::ostream &os, const BlockchainMessage &message);
+
+    /*
+     * Framing and encoding of messages on the wire.
+     *
+     * JSON frames are the JSON text terminated by '#', kept for debugging.
+     * Binary frames are a 4 byte little endian payload length followed by the
+     * payload: the message type, then a count and fixed size little endian
+     * records. The transactions of a block carry their read/write sets; those
+     * of the transaction messages do not.
+     *
+     * A codec keeps its JSON parser and writer between messages: values are
+     * allocated from a preallocated pool that is reset for each message, and
+     * the output buffer keeps its capacity, so a node that owns one codec does
+     * not allocate for messages that fit the pool.
+     */
+    class MessageCodec {
+        public:
+            MessageCodec(enum WireFormat format = JSON_FORMAT);
+            virtual ~MessageCodec(void);
+
+            enum WireFormat GetFormat(void) const;
+            void SetFormat(enum WireFormat format);
+
+            /* Appends the frame of message to frame */
+            void Encode(const BlockchainMessage &message, std::string &frame);
+
+            /*
+             * Looks for a complete frame at the start of data. Returns its size and
+             * where its payload lies, or 0 if more bytes are needed. A frame longer
+             * than MAX_FRAME_BYTES returns 0 and sets corrupt.
+             */
+            size_t FindFrame(const char *data, size_t size, size_t &payloadOffset, size_t &payloadSize, bool &corrupt) const;
+            /*
+             * Same, for data that grows between calls: the first scanned bytes are
+             * known to hold no JSON delimiter and are not searched again. scanned
+             * is advanced when 0 is returned and must be reset once the frame at
+             * the start of data is consumed.
+             */
+            size_t FindFrame(const char *data, size_t size, size_t &scanned, size_t &payloadOffset, size_t &payloadSize, bool &corrupt) const;
+
+            /*
+             * Returns false, with message in an unspecified state, on a malformed
+             * payload. JSON is parsed in place: the payload and the delimiter that
+             * follows it are overwritten.
+             */
+            bool Decode(char *payload, size_t size, BlockchainMessage &message);
+
+            static const uint32_t MAX_FRAME_BYTES = 64 * 1024 * 1024;
+            static const char JSON_DELIMITER = '#';
+            /* Bytes preallocated for the values of a parsed JSON message */
+            static const size_t JSON_POOL_BYTES = 32 * 1024;
+
+        protected:
+            MessageCodec(const MessageCodec &);
+            MessageCodec& operator = (const MessageCodec &);
+
+            struct JsonState;
+            JsonState& GetJsonState(void);
+
+            void EncodeBinary(const BlockchainMessage &message, std::string &frame);
+            void EncodeJson(const BlockchainMessage &message, std::string &frame);
+            bool DecodeBinary(const char *payload, size_t size, BlockchainMessage &message);
+            bool DecodeJson(char *payload, size_t size, BlockchainMessage &message);
+
+            enum WireFormat             m_format;
+            std::unique_ptr<JsonState>  m_json;     // created on first JSON use
+    };
+}
+
+#endif
@@ -17,6 +17,7 @@
 
 
 #include "blockchain-node.h"
+#include "ledger-snapshot.h"
 
 namespace ns3 {
     NS_LOG_COMPONENT_DEFINE("BlockchainNode");
@@ -42,10 +43,34 @@ namespace ns3 {
                       TimeValue(Minutes(2)),
                       MakeTimeAccessor(&BlockchainNode::m_invTimeoutMinutes),
                       MakeTimeChecker())
+        .AddAttribute("MaxOrphans",
+                      "The maximum number of orphan blocks kept, oldest are evicted first (0 = unbounded)",
+                      UintegerValue(1000),
+                      MakeUintegerAccessor(&BlockchainNode::m_maxOrphans),
+                      MakeUintegerChecker<uint32_t>())
+        .AddAttribute("MaxOrphanBytes",
+                      "The maximum total size in bytes of the orphan blocks kept (0 = unbounded)",
+                      UintegerValue(0),
+                      MakeUintegerAccessor(&BlockchainNode::m_maxOrphanBytes),
+                      MakeUintegerChecker<uint64_t>())
+        .AddAttribute("PruneDepth",
+                      "Blocks deeper than this below the best tip keep only their header (0 = no pruning)",
+                      UintegerValue(0),
+                      MakeUintegerAccessor(&BlockchainNode::m_pruneDepth),
+                      MakeUintegerChecker<uint32_t>())
+        .AddAttribute("PruneStaleForks",
+                      "Drop forks that branch off below the pruning depth",
+                      BooleanValue(false),
+                      MakeBooleanAccessor(&BlockchainNode::m_pruneStaleForks),
+                      MakeBooleanChecker())
         .AddTraceSource("Rx",
                         "A packet has been received",
                         MakeTraceSourceAccessor(&BlockchainNode::m_rxTrace),
-                        "ns3::Packet::AddressTracedCallback");
+                        "ns3::Packet::AddressTracedCallback")
+        .AddTraceSource("Reorg",
+                        "The best chain tip moved to a different fork",
+                        MakeTraceSourceAccessor(&BlockchainNode::m_reorgTrace),
+                        "ns3::BlockchainNode::ReorgTracedCallback");
 
         return tid;
     }
@@ -72,6 +97,7 @@ namespace ns3 {
         m_totalOrdering = 0;
         m_totalValidation = 0;
         m_totalCreatedTransaction = 0;
+        m_blockchain.SetReorgCallback(MakeCallback(&BlockchainNode::NotifyReorg, this));
     }
 
     BlockchainNode::~BlockchainNode(void) {
@@ -146,6 +172,9 @@ namespace ns3 {
             NS_LOG_INFO("\t " << *it);
         }
 
+        m_blockchain.SetOrphanLimits(m_maxOrphans, m_maxOrphanBytes);
+        m_blockchain.SetPruning(m_pruneDepth, m_pruneStaleForks);
+
         if(!m_socket)
         {
             m_socket = Socket::CreateSocket(GetNode(), m_tid);
@@ -251,6 +280,9 @@ namespace ns3 {
         m_nodeStats->meanBlockPropagationTime = m_meanBlockPropagationTime;
         m_nodeStats->meanBlockSize = m_meanBlockSize;
         m_nodeStats->totalBlocks = m_blockchain.GetTotalBlocks();
+        m_nodeStats->longestFork = m_blockchain.GetLongestFork();
+        m_nodeStats->blocksInForks = m_blockchain.GetBlocksInForks();
+        m_nodeStats->minedBlocksInMainChain = m_blockchain.GetMinedBlocksInMainChain(GetNode()->GetId());
         m_nodeStats->meanEndorsementTime = m_meanEndorsementTime;
         m_nodeStats->meanOrderingTime = m_meanOrderingTime;
         m_nodeStats->meanValidationTime = m_meanValidationTime;
@@ -306,39 +338,40 @@ namespace ns3 {
 
                             if(m_committerType != CLIENT) {
                                 unsigned int j;
-                                std::vector<std::string>    requestBlocks;
-                                std::vector<std::string>::iterator  block_it;
+                                std::vector<BlockId>                requestBlocks;
+                                std::vector<BlockId>::iterator      block_it;
 
                                 m_nodeStats->invReceivedBytes += m_blockchainMessageHeader + m_countBytes + document["inv"].Size()*m_inventorySizeBytes;
                                 for(j = 0; j < document["inv"].Size() ; j++)
                                 {
-                                    std::string invDelimiter = "/";
-                                    std::string parsedInv = document["inv"][j].GetString();
-                                    size_t invPos = parsedInv.find(invDelimiter);
+                                    BlockId blockId;
                                     EventId timeout;
 
-                                    int height = atoi(parsedInv.substr(0, invPos).c_str());
-                                    int minerId = atoi(parsedInv.substr(invPos+1, parsedInv.size()).c_str());
+                                    if(!BlockId::FromString(document["inv"][j].GetString(), blockId))
+                                    {
+                                        NS_LOG_WARN("INV : malformed inventory entry " << document["inv"][j].GetString());
+                                        continue;
+                                    }
 
-                                    if(m_blockchain.HasBlock(height, minerId) || m_blockchain.isOrphan(height, minerId) || ReceivedButNotValidated(parsedInv))
+                                    if(HasSeenBlock(blockId))
                                     {
                                         NS_LOG_INFO("INV : Blockchain node " << GetNode()->GetId()
                                                     << " has already received the block with height = "
-                                                    << height << " and minerId = " << minerId);
+                                                    << blockId.GetHeight() << " and minerId = " << blockId.GetMinerId());
                                     }
                                     else
                                     {
                                         NS_LOG_INFO("INV : Blockchain node " << GetNode()->GetId()
                                                     << " does not have the block with height = "
-                                                    << height << " and minerId = " << minerId);
+                                                    << blockId.GetHeight() << " and minerId = " << blockId.GetMinerId());
 
-                                        if(m_invTimeouts.find(parsedInv) == m_invTimeouts.end())
+                                        if(m_invTimeouts.find(blockId) == m_invTimeouts.end())
                                         {
                                             NS_LOG_INFO("INV: Blockchain node " << GetNode()->GetId()
                                                         << " has not requested the block yet");
-                                            requestBlocks.push_back(parsedInv);
-                                            timeout = Simulator::Schedule(m_invTimeoutMinutes, &BlockchainNode::InvTimeoutExpired, this, parsedInv);
-                                            m_invTimeouts[parsedInv] = timeout;
+                                            requestBlocks.push_back(blockId);
+                                            timeout = Simulator::Schedule(m_invTimeoutMinutes, &BlockchainNode::InvTimeoutExpired, this, blockId);
+                                            m_invTimeouts[blockId] = timeout;
                                         }
                                         else
                                         {
@@ -346,7 +379,7 @@ namespace ns3 {
                                                         << " has already requested the block");
                                         }
 
-                                        m_queueInv[parsedInv].push_back(from);
+                                        m_queueInv[blockId].push_back(from);
                                     }
                                 }
 
@@ -359,7 +392,8 @@ namespace ns3 {
 
                                     for(block_it = requestBlocks.begin(); block_it < requestBlocks.end(); block_it++)
                                     {
-                                        value.SetString(block_it->c_str(), block_it->size(), document.GetAllocator());
+                                        std::string blockHash = block_it->ToString();
+                                        value.SetString(blockHash.c_str(), blockHash.size(), document.GetAllocator());
                                         array.PushBack(value, document.GetAllocator());
                                     }
 
@@ -404,8 +438,8 @@ namespace ns3 {
                                     else
                                     {
                                         Transaction newTrans(nodeId, transId, timestamp);
-                                        m_transaction.push_back(newTrans);
-                                        //m_notValidatedTransaction.push_back(newTrans);
+                                        m_transactionPool.Add(newTrans, TransactionPool::RECEIVED);
+                                        //m_transactionPool.SetStage(newTrans.GetTxId(), TransactionPool::NOT_VALIDATED);
 
                                         if(m_committerType == ENDORSER)
                                         {
@@ -478,9 +512,6 @@ namespace ns3 {
         rapidjson::Value value;
         rapidjson::Value array(rapidjson::kArrayType);
 
-        std::ostringstream stringStream;
-        std::string blockHash = stringStream.str();
-
         document.SetObject();
 
         value.SetString("blocks");
@@ -490,8 +521,7 @@ namespace ns3 {
             value = INV;
             document.AddMember("message", value, document.GetAllocator());
 
-            stringStream << newBlock.GetBlockHeight() << "/" << newBlock.GetMinerId();
-            blockHash = stringStream.str();
+            std::string blockHash = newBlock.GetBlockId().ToString();
 
             value.SetString(blockHash.c_str(), blockHash.size(), document.GetAllocator());
             array.PushBack(value, document.GetAllocator());
@@ -520,46 +550,100 @@ namespace ns3 {
         NS_LOG_FUNCTION(this);
     }
 
-    bool BlockchainNode::HasTransaction(int nodeId, int transId) {
-        for(auto const &transaction: m_transaction) {
-            if(transaction.GetTransactionNodeId() == nodeId && transaction.GetTransactionId() == transId)
-                return true;
+    void BlockchainNode::NotifyReorg(BlockHandle oldTip, BlockHandle newTip, int depth) {
+        NS_LOG_FUNCTION(this);
+        const Block &oldBlock = m_blockchain.GetBlock(oldTip);
+        const Block &newBlock = m_blockchain.GetBlock(newTip);
+
+        NS_LOG_INFO("Reorg: At time " << Simulator::Now().GetSeconds()
+                    << "s blockchain node " << GetNode()->GetId() << " switched from block "
+                    << oldBlock.GetBlockId() << " to " << newBlock.GetBlockId() << " (depth " << depth << ")");
+        m_reorgTrace(oldBlock, newBlock, depth);
+    }
+
+    bool BlockchainNode::ReceivedButNotValidated(const BlockId &blockId) const {
+        return m_receivedNotValidated.find(blockId) != m_receivedNotValidated.end();
+    }
+
+    void BlockchainNode::SaveSnapshot(std::ostream &os) const {
+        SnapshotWriter writer(os);
+
+        m_blockchain.Save(os);
+        std::vector<Transaction> transactions;
+        std::vector<Transaction> notValidated;
+
+        m_transactionPool.GetTransactions(TransactionPool::RECEIVED, transactions);
+        m_transactionPool.GetTransactions(TransactionPool::NOT_VALIDATED, notValidated);
+        writer.WriteTransactions(transactions);
+        writer.WriteTransactions(notValidated);
+    }
+
+    bool BlockchainNode::RestoreSnapshot(std::istream &is) {
+        SnapshotReader reader(is);
+        BlockchainSnapshot snapshot;
+        std::vector<Transaction> transactions;
+        std::vector<Transaction> notValidated;
+
+        // Nothing is replaced until the whole snapshot has been read
+        if(!Blockchain::ReadSnapshot(is, snapshot) || !reader.ReadTransactions(transactions) || !reader.ReadTransactions(notValidated)) {
+            return false;
+        }
+
+        m_blockchain.ApplySnapshot(std::move(snapshot));
+
+        // Blocks in flight refer to the ledger that was replaced
+        for(auto &timeout : m_invTimeouts) {
+            Simulator::Cancel(timeout.second);
+        }
+        m_invTimeouts.clear();
+        m_queueInv.clear();
+        m_receivedNotValidated.clear();
+        m_onlyHeadersReceived.clear();
+
+        m_transactionPool.Clear();
+        for(auto const &transaction : transactions) {
+            m_transactionPool.Add(transaction, TransactionPool::RECEIVED);
+        }
+        for(auto const &transaction : notValidated) {
+            m_transactionPool.Add(transaction, TransactionPool::NOT_VALIDATED);
         }
-        return false;
+        return true;
+    }
+
+    bool BlockchainNode::HasSeenBlock(const BlockId &blockId) const {
+        if(m_blockchain.MayContainBlock(blockId) && (m_blockchain.HasBlock(blockId) || m_blockchain.isOrphan(blockId)))
+            return true;
+        return ReceivedButNotValidated(blockId);
+    }
+
+    void BlockchainNode::RemoveReceivedButNotvalidated(const BlockId &blockId) {
+        m_receivedNotValidated.erase(blockId);
+    }
+
+    bool BlockchainNode::OnlyHeadersReceived(const BlockId &blockId) const {
+        return m_onlyHeadersReceived.find(blockId) != m_onlyHeadersReceived.end();
+    }
+
+    bool BlockchainNode::HasTransaction(int nodeId, int transId) {
+        return m_transactionPool.Has(TxId(nodeId, transId), TransactionPool::RECEIVED);
     }
 
     bool BlockchainNode::HasReplyTransaction(int nodeId, int transId, int transExecution) {
-        for(auto const &transaction: m_replyTransaction) {
-            if(transaction.GetTransactionNodeId() == nodeId && transaction.GetTransactionId() == transId && transaction.GetExecution() == transExecution)
-                return true;
-        }
-        return false;
+        return m_transactionPool.HasReply(TxId(nodeId, transId), transExecution);
     }
 
     bool BlockchainNode::HasMessageTransaction(int nodeId, int transId) {
-        for(auto const &transaction: m_msgTransaction) {
-            if(transaction.GetTransactionNodeId() == nodeId && transaction.GetTransactionId() == transId) {
-                return true;
-            }
-        }
-        return false;
+        return m_transactionPool.Has(TxId(nodeId, transId), TransactionPool::MESSAGE);
     }
 
     bool BlockchainNode::HasResultTransaction(int nodeId, int transId) {
-        for(auto const &transaction: m_resultTransaction) {
-            if(transaction.GetTransactionNodeId() == nodeId && transaction.GetTransactionId() == transId) {
-                return true;
-            }
-        }
-        return false;
+        return m_transactionPool.Has(TxId(nodeId, transId), TransactionPool::RESULT);
     }
 
     bool BlockchainNode::HasTransactionAndValidated(int nodeId, int transId) {
-        for(auto const &transaction: m_transaction) {
-            if(transaction.GetTransactionNodeId() == nodeId && transaction.GetTransactionId() == transId && transaction.IsValidated() == true)
-                return true;
-        }
-        return false;
+        TransactionSlot slot = m_transactionPool.Find(TxId(nodeId, transId));
+        return slot != INVALID_TRANSACTION_SLOT && (m_transactionPool.GetStages(slot) & TransactionPool::RECEIVED)
+               && m_transactionPool.IsValidated(slot);
     }
 
 }
\ No newline at end of file
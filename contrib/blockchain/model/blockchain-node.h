@@ -2,6 +2,7 @@
 #define BLOCKCHAIN_NODE_H
 
 #include <algorithm>
+#include <unordered_map>
 #include "ns3/application.h"
 #include "ns3/event-id.h"
 #include "ns3/ptr.h"
@@ -10,6 +11,7 @@
 #include "ns3/boolean.h"
 
 #include "blockchain.h"
+#include "transaction-pool.h"
 #include "util.h"
 #include "../../../rapidjson/document.h"
 #include "../../../rapidjson/writer.h"
@@ -45,6 +47,19 @@ namespace ns3 {
 
             void SetCreatingTransactionTime(int cTime);
 
+            /*
+             * Snapshot of the ledger and of the transaction pools, so that runs can
+             * start from a warmed-up node instead of the genesis block. Restore it
+             * before the application starts. Restore returns false, leaving the node
+             * untouched, if the stream does not hold a complete snapshot; otherwise
+             * the blocks the node was still fetching are forgotten.
+             */
+            void SaveSnapshot(std::ostream &os) const;
+            bool RestoreSnapshot(std::istream &is);
+
+            /* Signature of the Reorg trace: old best tip, new best tip, depth of the abandoned chain */
+            typedef void (* ReorgTracedCallback)(const Block &oldTip, const Block &newTip, int depth);
+
         protected:
             virtual void DoDispose (void);
             virtual void StartApplication (void);
@@ -62,6 +77,7 @@ namespace ns3 {
             void ValidateTransaction(const Block &newBlock);
             void AfterBlockValidation(const Block &newBlock);
             void ValudateOrphanChildren(const Block &newBlock);
+            void NotifyReorg(BlockHandle oldTip, BlockHandle newTip, int depth);
             
             void AdvertiseNewBlock(const Block &newBlock);
             void AdvertiseNewTransaction(const Transaction &newTrans, enum Messages msgType, Ipv4Address receivedFromIpv4);
@@ -84,10 +100,13 @@ namespace ns3 {
             void SendMessage(enum Messages receivedMessage, enum Messages responseMessage, 
                             std::string packet, Address &outgoingAddress);
 
-            void InvTimeoutExpired (std::string blockHash);
-            bool ReceivedButNotValidated(std::string blockHash);
-            void RemoveReceivedButNotvalidated(std::string blockHash);
-            bool OnlyHeadersReceived (std::string blockHash);
+            void InvTimeoutExpired (BlockId blockId);
+            bool ReceivedButNotValidated(const BlockId &blockId) const;
+
+            /* Ledger, orphan pool or pending validation; the bloom filter answers most misses */
+            bool HasSeenBlock(const BlockId &blockId) const;
+            void RemoveReceivedButNotvalidated(const BlockId &blockId);
+            bool OnlyHeadersReceived (const BlockId &blockId) const;
             
             void RemoveSendTime();
             void RemoveCompressedBlockSendTime();
@@ -122,22 +141,21 @@ namespace ns3 {
             int             m_totalValidation;
             int             m_totalCreatedTransaction;
             int             m_creatingTransactionTime;
+            uint32_t        m_maxOrphans;
+            uint64_t        m_maxOrphanBytes;
+            uint32_t        m_pruneDepth;
+            bool            m_pruneStaleForks;
 
-            std::vector<Transaction>                        m_transaction;
-            std::vector<Transaction>                        m_notValidatedTransaction;
-            std::vector<Transaction>                        m_replyTransaction;
-            std::vector<Transaction>                        m_msgTransaction;
-            std::vector<Transaction>                        m_resultTransaction;
-            std::vector<Transaction>                        m_waitingEndorsers;
+            TransactionPool                                 m_transactionPool;      // received, not validated, reply, message, result, waiting endorsers
             std::vector<Ipv4Address>                        m_peersAddresses;
             std::map<Ipv4Address, double>                   m_peersDownloadSpeeds;
             std::map<Ipv4Address, double>                   m_peersUploadSpeeds; 
             std::map<Ipv4Address, Ptr<Socket>>              m_peersSockets;  
-            std::map<std::string, std::vector<Address>>     m_queueInv;
-            std::map<std::string, EventId>                  m_invTimeouts;
+            std::unordered_map<BlockId, std::vector<Address>>   m_queueInv;
+            std::unordered_map<BlockId, EventId>                m_invTimeouts;
             std::map<Address, std::string>                  m_bufferedData;  
-            std::map<std::string, Block>                    m_receivedNotValidated;
-            std::map<std::string, Block>                    m_onlyHeadersReceived;
+            std::unordered_map<BlockId, Block>                  m_receivedNotValidated;
+            std::unordered_map<BlockId, Block>                  m_onlyHeadersReceived;
             nodeStatistics                                  *m_nodeStats;    
             std::vector<double>                             m_sendBlockTimes;
             std::vector<double>                             m_sendCompressedBlockTimes;
@@ -157,6 +175,7 @@ namespace ns3 {
             const int       m_blockHeadersSizeBytes;
 
             TracedCallback<Ptr<const Packet>, const Address &> m_rxTrace;
+            TracedCallback<const Block &, const Block &, int>  m_reorgTrace;
 
     };
 }
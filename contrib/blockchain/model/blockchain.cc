@@ -1,4 +1,5 @@
 /* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#include <utility>
 #include "ns3/application.h"
 #include "ns3/event-id.h"
 #include "ns3/ptr.h"
@@ -6,13 +7,18 @@
 #include "ns3/address.h"
 #include "ns3/log.h"
 #include "ns3/inet-socket-address.h"
+#include "ns3/singleton.h"
 
 
 #include "blockchain.h"
+#include "block-store.h"
+#include "ledger-snapshot.h"
 #include "util.h"
 
 namespace ns3 {
-    Blockchain::Blockchain(void) {
+    Blockchain::Blockchain(void)
+        : m_checkpointDepth(0), m_dropStaleForks(false), m_checkpointHeight(0), m_finalizedMainChain(0),
+          m_prunedForkBlocks(0), m_prunedLongestFork(0) {
         m_totalBlocks = 0;
         Block genesisBlock(0,0,0,0,0,0,0, Ipv4Address("0.0.0.0"));
         AddBlock(genesisBlock);
@@ -24,191 +30,629 @@ namespace ns3 {
         return m_totalBlocks;
     }
 
+    int Blockchain::GetNoOrphans(void) const {
+        return m_orphans.GetSize();
+    }
+
     int Blockchain::GetBlockchainHeight(void) const {
-        return GetCurrentTopBlock()->GetBlockHeight();
+        return m_forkChoice.GetBestHeight();
     }
 
     bool Blockchain::HasBlock(const Block &block) const {
-        if(block.GetBlockHeight() > GetCurrentTopBlock()->GetBlockHeight()) {
-            return false;
-        } else {
-            for (auto const &i_block : m_blocks[block.GetBlockHeight()]) {
-                if(i_block == block) {
-                    return true;
-                }
-            }
-        }
-        return false;
+        return HasBlock(block.GetBlockHeight(), block.GetMinerId());
     }
 
     bool Blockchain::HasBlock(int height, int minerId) const {
-        if(height > GetCurrentTopBlock()->GetBlockHeight()) {
-            return false;
-        } else {
-            for (auto const &block : m_blocks[height]) {
-                if(block.GetBlockHeight() == height && block.GetMinerId() == minerId) {
-                    return true;
-                
-                }
-            }
-        }
-        return false;
+        return HasBlock(BlockId(height, minerId));
+    }
+
+    bool Blockchain::HasBlock(const BlockId &id) const {
+        return m_blockIndex.find(id) != m_blockIndex.end();
     }
 
     Block Blockchain::ReturnBlock(int height, int minerId) {
-        std::vector<Block>::iterator block_it;
+        BlockHandle handle = GetBlockHandle(height, minerId);
 
-        if(height <= GetBlockchainHeight() && height >= 0) {
-            for(block_it = m_blocks[height].begin(); block_it < m_blocks[height].end(); block_it++) {
-                if(block_it->GetBlockHeight() == height && block_it->GetMinerId() == minerId) {
-                    return *block_it;
-                
-                }
-            }
+        if(handle != INVALID_BLOCK_HANDLE) {
+            return m_arena.Get(handle).view;
         }
+        return Block();
+    }
 
-        for(block_it = m_blocks[height].begin(); block_it < m_blocks[height].end(); block_it++) {
-            if(block_it->GetBlockHeight() == height && block_it->GetMinerId() == minerId) {
-                return *block_it;
-            
-            }
+    BlockHandle Blockchain::GetBlockHandle(int height, int minerId) const {
+        return GetBlockHandle(BlockId(height, minerId));
+    }
+
+    BlockHandle Blockchain::GetBlockHandle(const BlockId &id) const {
+        auto it = m_blockIndex.find(id);
+
+        if(it == m_blockIndex.end()) {
+            return INVALID_BLOCK_HANDLE;
         }
+        return it->second;
+    }
 
-        return Block();
+    const Block& Blockchain::GetBlock(BlockHandle handle) const {
+        return m_arena.Get(handle).view;
+    }
+
+    std::shared_ptr<const Block> Blockchain::GetSharedBlock(BlockHandle handle) const {
+        return m_arena.Get(handle).block;
+    }
+
+    double Blockchain::GetTimeReceived(BlockHandle handle) const {
+        return m_arena.Get(handle).view.GetTimeReceived();
+    }
+
+    Ipv4Address Blockchain::GetReceivedFromIpv4(BlockHandle handle) const {
+        return m_arena.Get(handle).view.GetReceivedFromIpv4();
     }
 
     bool Blockchain::isOrphan (const Block &newBlock) const {
-        for(auto const &block: m_orphans) {
-            if(block == newBlock) {
-                return true;
-            }
-        }
-        return false;
+        return isOrphan(newBlock.GetBlockHeight(), newBlock.GetMinerId());
     }
 
     bool Blockchain::isOrphan (int height, int minerId) const {
-        for(auto const &block: m_orphans) {
-            if(block.GetBlockHeight() == height && block.GetMinerId() == minerId) {
-                return true;
+        return m_orphans.Has(height, minerId);
+    }
+
+    bool Blockchain::isOrphan (const BlockId &id) const {
+        return m_orphans.Has(id.GetHeight(), id.GetMinerId());
+    }
+
+    bool Blockchain::MayContainBlock(const BlockId &id) const {
+        return m_seenBlocks.MayContain(id.GetPacked());
+    }
+
+    void Blockchain::AddSeenBlock(const BlockId &id) {
+        m_seenBlocks.Insert(id.GetPacked());
+
+        if(m_seenBlocks.NeedsRebuild()) {
+            // Refill from the exact indexes, dropping pruned blocks and evicted orphans
+            std::vector<BlockId> ids;
+            ids.reserve(m_blockIndex.size() + m_orphans.GetSize());
+            for(auto const &block : m_blockIndex) {
+                ids.push_back(block.first);
+            }
+            m_orphans.GetIds(ids);
+
+            m_seenBlocks.Reset(2 * ids.size());
+            for(auto const &seen : ids) {
+                m_seenBlocks.Insert(seen.GetPacked());
             }
         }
-        return false;
     }
     
     const Block* Blockchain::GetBlockPointer(const Block &newBlock) const {
-        for(auto const &block : m_blocks[newBlock.GetBlockHeight()]) {
-            if(block == newBlock) {
-                return &block;
-            }
+        BlockHandle handle = GetBlockHandle(newBlock.GetBlockHeight(), newBlock.GetMinerId());
+
+        if(handle != INVALID_BLOCK_HANDLE) {
+            return &GetBlock(handle);
         }
         return NULL;
     }
 
     const std::vector<const Block *> Blockchain::GetChildrenPointers (const Block &block) {
         std::vector<const Block *> children;
-        std::vector<Block>::iterator block_it;
-        int childrenHeight = block.GetBlockHeight() + 1;
+        auto adj = m_children.find(block.GetBlockId());
 
-        if(childrenHeight > GetBlockchainHeight())
-        {
+        if(adj == m_children.end()) {
             return children;
         }
 
-        for(block_it = m_blocks[childrenHeight].begin(); block_it < m_blocks[childrenHeight].end(); block_it++)
-        {
-            if(block.IsParent(*block_it))
-            {
-                children.push_back(&(*block_it));
-            }
+        children.reserve(adj->second.size());
+        for(auto const &child : adj->second) {
+            children.push_back(&GetBlock(child));
         }
-
         return children;
     }
 
 
     const std::vector<const Block *> Blockchain::GetOrpharnChildrenPointer (const Block &block)
     {
-        std::vector<const Block *> children;
-        std::vector<Block>::iterator block_it;
-
-        for(block_it = m_orphans.begin(); block_it < m_orphans.end(); block_it++)
-        {
-            if(block.IsParent(*block_it))
-            {
-                children.push_back(&(*block_it));
-            }
-        }
-        return children;
+        return m_orphans.GetWaitingOn(block);
     }
 
     
     const Block* Blockchain::GetParent(const Block &block)
     {
-        std::vector<Block>::iterator block_it;
-        int parentHeight = block.GetBlockHeight() - 1;
+        if(block.GetBlockHeight() <= 0) {
+            return nullptr;
+        }
 
-        if(parentHeight > GetBlockchainHeight() || parentHeight < 0)
+        auto it = m_blockIndex.find(block.GetParentBlockId());
+        if(it == m_blockIndex.end()) {
             return nullptr;
-        
-        for(block_it = m_blocks[parentHeight].begin(); block_it < m_blocks[parentHeight].end(); block_it++)
-        {
-            if(block.IsChild(*block_it))
-            {
-                return &(*block_it);
-            }
         }
-        return nullptr;
+        return &GetBlock(it->second);
     }
 
     
     const Block* Blockchain::GetCurrentTopBlock(void) const {
-        return &m_blocks[m_blocks.size()-1][0];
+        return &GetBlock(m_forkChoice.GetBestTip());
+    }
+
+    BlockHandle Blockchain::GetBestTip(void) const {
+        return m_forkChoice.GetBestTip();
+    }
+
+    const std::unordered_set<BlockHandle>& Blockchain::GetChainTips(void) const {
+        return m_forkChoice.GetTips();
+    }
+
+    BlockHandle Blockchain::FindCommonAncestor(BlockHandle a, BlockHandle b) const {
+        return m_forkChoice.FindCommonAncestor(a, b);
+    }
+
+    BlockHandle Blockchain::GetAncestorAtHeight(BlockHandle block, int height) const {
+        return m_forkChoice.GetAncestor(block, height);
+    }
+
+    void Blockchain::SetReorgCallback(ForkChoice::ReorgCallback reorg) {
+        m_forkChoice.SetReorgCallback(reorg);
+    }
+
+    int Blockchain::GetReorgCount(void) const {
+        return m_forkChoice.GetReorgCount();
     }
 
     
-    void Blockchain::AddBlock(const Block& newBlock)
+    int Blockchain::AddBlock(const Block& newBlock)
+    {
+        return AddBlock(Block(newBlock));
+    }
+
+    int Blockchain::AddBlock(Block&& newBlock)
     {
+        RemoveOrphan(newBlock);
+        BlockHandle handle = InsertBlock(std::move(newBlock));
 
-        if(m_blocks.size() == 0) {
-           std::vector<Block> newHeight(1, newBlock);
-           m_blocks.push_back(newHeight);
+        std::vector<Block> attached = m_orphans.ReleaseDescendants(GetBlock(handle));
+        for(auto &orphan : attached) {
+            InsertBlock(std::move(orphan));
         }
-        else if(newBlock.GetBlockHeight() > GetCurrentTopBlock()->GetBlockHeight()) {
-           int dummyRows = newBlock.GetBlockHeight() - GetCurrentTopBlock()->GetBlockHeight()-1;
+        Prune();
+        return attached.size();
+    }
 
-           for(int i = 0 ; i < dummyRows; i++) {
-               std::vector<Block> newHeight;
-               m_blocks.push_back(newHeight);
-           }
+    BlockHandle Blockchain::InsertBlock(Block&& newBlock)
+    {
+        int height = newBlock.GetBlockHeight();
+        BlockId id = newBlock.GetBlockId();
 
-           std::vector<Block> newHeight(1, newBlock);
-           m_blocks.push_back(newHeight);
-        } else {
-            m_blocks[newBlock.GetBlockHeight()].push_back(newBlock);
+        auto existing = m_blockIndex.find(id);
+        if(existing != m_blockIndex.end()) {
+            return existing->second;
+        }
+
+        LedgerBlock entry;
+        entry.view.SetTimeReceived(newBlock.GetTimeReceived());
+        entry.view.SetReceivedFromIpv4(newBlock.GetReceivedFromIpv4());
+        // Whichever ledger stores the block first, the shared copy holds no reception details
+        newBlock.SetTimeReceived(0);
+        newBlock.SetReceivedFromIpv4(Ipv4Address());
+        ShareBlock(entry, Singleton<BlockStore>::Get()->Intern(std::move(newBlock)));
+        BlockHandle handle = m_arena.Allocate(entry);
+        const Block &block = GetBlock(handle);
+
+        if(height >= static_cast<int>(m_blocks.size())) {
+            m_blocks.resize(height + 1);
+        }
+        m_blocks[height].push_back(handle);
+        m_blockIndex[id] = handle;
+        AddSeenBlock(id);
+
+        BlockHandle parent = INVALID_BLOCK_HANDLE;
+        if(height > 0) {
+            parent = GetBlockHandle(height - 1, block.GetParentBlockMinerId());
+            m_children[block.GetParentBlockId()].push_back(handle);
+        }
+        m_forkChoice.AddBlock(handle, parent, height, 1, m_children.find(id) != m_children.end());
+        AttachChildren(handle);
+
+        for(uint32_t position = 0; position < block.GetTransactionCount(); position++) {
+            TxLocation location = { handle, position };
+            m_txIndex.insert(std::make_pair(block.GetTransaction(position).GetTxId(), location));
         }
         m_totalBlocks++;
+        return handle;
+    }
+
+    void Blockchain::ShareBlock(LedgerBlock &entry, std::shared_ptr<const Block> block) {
+        double timeReceived = entry.view.GetTimeReceived();
+        Ipv4Address receivedFromIpv4 = entry.view.GetReceivedFromIpv4();
+
+        // The view copies the header and shares the transaction list of the shared block
+        entry.block = std::move(block);
+        entry.view = *entry.block;
+        entry.view.SetTimeReceived(timeReceived);
+        entry.view.SetReceivedFromIpv4(receivedFromIpv4);
+    }
+
+    void Blockchain::AttachChildren(BlockHandle handle) {
+        std::vector<BlockHandle> pending(1, handle);
+
+        // Blocks that arrived before handle were linked without their ancestry; top down, like the orphans
+        for(size_t next = 0; next < pending.size(); next++) {
+            auto adj = m_children.find(GetBlock(pending[next]).GetBlockId());
+
+            if(adj == m_children.end()) {
+                continue;
+            }
+            for(auto const &child : adj->second) {
+                m_forkChoice.AttachChild(child, pending[next]);
+                pending.push_back(child);
+            }
+        }
     }
 
     
     void Blockchain::AddOrphan(const Block& newBlock) {
-        m_orphans.push_back(newBlock);
+        AddOrphan(Block(newBlock));
+    }
+
+    void Blockchain::AddOrphan(Block&& newBlock) {
+        BlockId id = newBlock.GetBlockId();
+
+        if(m_orphans.Add(std::move(newBlock))) {
+            AddSeenBlock(id);
+        }
     }
 
     
     void Blockchain::RemoveOrphan(const Block& newBlock) {
-        std::vector<Block>::iterator block_it;
+        m_orphans.Remove(newBlock.GetBlockHeight(), newBlock.GetMinerId());
+    }
+
+    bool Blockchain::HasTransaction(int nodeId, int transId) const {
+        return HasTransaction(TxId(nodeId, transId));
+    }
+
+    bool Blockchain::HasTransaction(const TxId &id) const {
+        return m_txIndex.find(id) != m_txIndex.end();
+    }
+
+    bool Blockchain::GetTransactionLocation(const TxId &id, TxLocation &location) const {
+        auto range = m_txIndex.equal_range(id);
+
+        if(range.first == range.second) {
+            return false;
+        }
 
-        for(block_it = m_orphans.begin(); block_it < m_orphans.end(); block_it++) {
-            if(newBlock==*block_it) {
+        location = range.first->second;
+        for(auto it = range.first; it != range.second; ++it) {
+            if(IsOnMainChain(it->second.block)) {
+                location = it->second;
                 break;
             }
         }
-        
-        if(block_it == m_orphans.end()) {
-            return;
+        return true;
+    }
+
+    const Transaction* Blockchain::FindTransaction(const TxId &id) const {
+        TxLocation location;
+
+        if(!GetTransactionLocation(id, location)) {
+            return nullptr;
+        }
+
+        const Block &block = GetBlock(location.block);
+        return location.position < block.GetTransactionCount() ? &block.GetTransaction(location.position) : nullptr;
+    }
+
+    bool Blockchain::IsOnMainChain(BlockHandle handle) const {
+        return GetAncestorAtHeight(GetBestTip(), m_forkChoice.GetHeight(handle)) == handle;
+    }
+
+    void Blockchain::SetOrphanLimits(uint32_t maxOrphans, uint64_t maxOrphanBytes) {
+        m_orphans.SetMaxOrphans(maxOrphans);
+        m_orphans.SetMaxOrphanBytes(maxOrphanBytes);
+    }
+
+    uint64_t Blockchain::GetEvictedOrphans(void) const {
+        return m_orphans.GetEvictedOrphans();
+    }
+
+    void Blockchain::SetPruning(int checkpointDepth, bool dropStaleForks) {
+        m_checkpointDepth = checkpointDepth;
+        m_dropStaleForks = dropStaleForks;
+        Prune();
+    }
+
+    int Blockchain::GetCheckpointHeight(void) const {
+        return m_checkpointHeight;
+    }
+
+    int Blockchain::GetBlocksInForks(void) const {
+        int liveMainChain = 0;
+        BlockHandle best = GetBestTip();
+
+        if(GetAncestorAtHeight(best, m_checkpointHeight) != INVALID_BLOCK_HANDLE) {
+            liveMainChain = m_forkChoice.GetHeight(best) - m_checkpointHeight + 1;
         } else {
-            m_orphans.erase(block_it);
+            // The main chain does not reach the checkpoint, count what is there
+            for(BlockHandle block = best; block != INVALID_BLOCK_HANDLE && m_forkChoice.GetHeight(block) >= m_checkpointHeight;
+                block = m_forkChoice.GetParent(block)) {
+                liveMainChain++;
+            }
+        }
+        return m_prunedForkBlocks + m_arena.GetSize() - m_finalizedMainChain - liveMainChain;
+    }
+
+    int Blockchain::GetLongestFork(void) const {
+        int longestFork = m_prunedLongestFork;
+        BlockHandle best = GetBestTip();
+
+        for(auto const &tip : GetChainTips()) {
+            if(tip == best) {
+                continue;
+            }
+
+            BlockHandle ancestor = m_forkChoice.FindCommonAncestor(tip, best);
+            int forkPoint = ancestor != INVALID_BLOCK_HANDLE ? m_forkChoice.GetHeight(ancestor) : -1;
+            longestFork = std::max(longestFork, m_forkChoice.GetHeight(tip) - forkPoint);
+        }
+        return longestFork;
+    }
+
+    int Blockchain::GetMinedBlocksInMainChain(int minerId) const {
+        auto finalized = m_finalizedMinedBlocks.find(minerId);
+        int mined = finalized != m_finalizedMinedBlocks.end() ? finalized->second : 0;
+
+        for(BlockHandle block = GetBestTip(); block != INVALID_BLOCK_HANDLE && m_forkChoice.GetHeight(block) >= m_checkpointHeight;
+            block = m_forkChoice.GetParent(block)) {
+            if(m_forkChoice.GetHeight(block) > 0 && GetBlock(block).GetMinerId() == minerId) {
+                mined++;
+            }
+        }
+        return mined;
+    }
+
+    void Blockchain::Prune(void) {
+        if(m_checkpointDepth <= 0) {
+            return;
+        }
+
+        int checkpoint = GetBlockchainHeight() - m_checkpointDepth;
+        if(checkpoint <= m_checkpointHeight) {
+            return;
         }
+
+        // Main chain block of every height that becomes final
+        std::vector<BlockHandle> mainChain(checkpoint - m_checkpointHeight, INVALID_BLOCK_HANDLE);
+        for(BlockHandle block = GetAncestorAtHeight(GetBestTip(), checkpoint - 1);
+            block != INVALID_BLOCK_HANDLE && m_forkChoice.GetHeight(block) >= m_checkpointHeight;
+            block = m_forkChoice.GetParent(block)) {
+            mainChain[m_forkChoice.GetHeight(block) - m_checkpointHeight] = block;
+        }
+
+        for(int height = m_checkpointHeight; height < checkpoint; height++) {
+            BlockHandle main = mainChain[height - m_checkpointHeight];
+
+            if(main != INVALID_BLOCK_HANDLE) {
+                m_finalizedMainChain++;
+                if(height > 0) {
+                    m_finalizedMinedBlocks[GetBlock(main).GetMinerId()]++;
+                }
+            }
+
+            // Stale blocks whose parent was stale are already gone with their parent's branch
+            std::vector<BlockHandle> row(m_blocks[height]);
+            for(auto const &block : row) {
+                if(block != main && m_dropStaleForks) {
+                    int forkPoint = height - 1;
+                    int forkTop = DropBranch(block);
+                    m_prunedLongestFork = std::max(m_prunedLongestFork, forkTop - forkPoint);
+                } else {
+                    LedgerBlock &entry = m_arena.Get(block);
+                    ShareBlock(entry, Singleton<BlockStore>::Get()->InternHeader(*entry.block));
+                }
+            }
+        }
+        m_checkpointHeight = checkpoint;
+    }
+
+    int Blockchain::DropBranch(BlockHandle root) {
+        const Block &rootBlock = GetBlock(root);
+        int forkTop = rootBlock.GetBlockHeight();
+
+        if(rootBlock.GetBlockHeight() > 0) {
+            auto siblings = m_children.find(rootBlock.GetParentBlockId());
+            if(siblings != m_children.end()) {
+                siblings->second.erase(std::remove(siblings->second.begin(), siblings->second.end(), root), siblings->second.end());
+            }
+        }
+
+        std::vector<BlockHandle> pending(1, root);
+        while(!pending.empty()) {
+            BlockHandle handle = pending.back();
+            pending.pop_back();
+
+            const Block &block = GetBlock(handle);
+            int height = block.GetBlockHeight();
+            BlockId id = block.GetBlockId();
+
+            for(uint32_t position = 0; position < block.GetTransactionCount(); position++) {
+                auto range = m_txIndex.equal_range(block.GetTransaction(position).GetTxId());
+                for(auto it = range.first; it != range.second;) {
+                    if(it->second.block == handle) {
+                        it = m_txIndex.erase(it);
+                    } else {
+                        ++it;
+                    }
+                }
+            }
+
+            auto children = m_children.find(id);
+            if(children != m_children.end()) {
+                pending.insert(pending.end(), children->second.begin(), children->second.end());
+                m_children.erase(children);
+            }
+
+            std::vector<BlockHandle> &row = m_blocks[height];
+            row.erase(std::remove(row.begin(), row.end(), handle), row.end());
+            m_blockIndex.erase(id);
+            m_forkChoice.RemoveBlock(handle);
+            m_arena.Release(handle);
+
+            forkTop = std::max(forkTop, height);
+            m_prunedForkBlocks++;
+        }
+        return forkTop;
+    }
+
+    static const uint32_t SNAPSHOT_MAGIC = 0x5244474c;     // "LDGR"
+    static const uint32_t SNAPSHOT_VERSION = 3;
+
+    void Blockchain::Save(std::ostream &os) const {
+        SnapshotWriter writer(os);
+
+        writer.WriteU32(SNAPSHOT_MAGIC);
+        writer.WriteU32(SNAPSHOT_VERSION);
+
+        writer.WriteInt(m_totalBlocks);
+        writer.WriteInt(m_forkChoice.GetReorgCount());
+        writer.WriteInt(m_forkChoice.GetMaxReorgDepth());
+        writer.WriteInt(m_checkpointDepth);
+        writer.WriteBool(m_dropStaleForks);
+        writer.WriteInt(m_checkpointHeight);
+        writer.WriteInt(m_finalizedMainChain);
+        writer.WriteInt(m_prunedForkBlocks);
+        writer.WriteInt(m_prunedLongestFork);
+        writer.WriteU32(m_finalizedMinedBlocks.size());
+        for(auto const &mined : m_finalizedMinedBlocks) {
+            writer.WriteInt(mined.first);
+            writer.WriteInt(mined.second);
+        }
+
+        // By height, each row in arrival order, so that fork choice ties resolve the same way
+        writer.WriteU32(m_arena.GetSize());
+        for(auto const &row : m_blocks) {
+            for(auto const &handle : row) {
+                writer.WriteBlock(GetBlock(handle));
+            }
+        }
+
+        std::vector<BlockId> orphans;
+        m_orphans.GetIds(orphans);
+        writer.WriteU32(orphans.size());
+        for(auto const &id : orphans) {
+            writer.WriteBlock(*m_orphans.Get(id.GetHeight(), id.GetMinerId()));
+        }
+
+        // Saved as is since blocks pruned to their header no longer carry their transactions
+        writer.WriteU32(m_txIndex.size());
+        for(auto const &tx : m_txIndex) {
+            const Block &block = GetBlock(tx.second.block);
+            writer.WriteInt(tx.first.GetNodeId());
+            writer.WriteInt(tx.first.GetTransId());
+            writer.WriteInt(block.GetBlockHeight());
+            writer.WriteInt(block.GetMinerId());
+            writer.WriteU32(tx.second.position);
+        }
+    }
+
+    bool Blockchain::Restore(std::istream &is) {
+        BlockchainSnapshot snapshot;
+
+        if(!ReadSnapshot(is, snapshot)) {
+            return false;
+        }
+        ApplySnapshot(std::move(snapshot));
+        return true;
+    }
+
+    bool Blockchain::ReadSnapshot(std::istream &is, BlockchainSnapshot &snapshot) {
+        SnapshotReader reader(is);
+
+        if(reader.ReadU32() != SNAPSHOT_MAGIC || reader.ReadU32() != SNAPSHOT_VERSION) {
+            return false;
+        }
+
+        snapshot.totalBlocks = reader.ReadInt();
+        snapshot.reorgs = reader.ReadInt();
+        snapshot.maxReorgDepth = reader.ReadInt();
+        snapshot.checkpointDepth = reader.ReadInt();
+        snapshot.dropStaleForks = reader.ReadBool();
+        snapshot.checkpointHeight = reader.ReadInt();
+        snapshot.finalizedMainChain = reader.ReadInt();
+        snapshot.prunedForkBlocks = reader.ReadInt();
+        snapshot.prunedLongestFork = reader.ReadInt();
+
+        snapshot.finalizedMinedBlocks.clear();
+        uint32_t miners = reader.ReadU32();
+        for(uint32_t i = 0; i < miners && reader.IsGood(); i++) {
+            int minerId = reader.ReadInt();
+            snapshot.finalizedMinedBlocks[minerId] = reader.ReadInt();
+        }
+
+        snapshot.blocks.clear();
+        uint32_t count = reader.ReadU32();
+        for(uint32_t i = 0; i < count && reader.IsGood(); i++) {
+            snapshot.blocks.push_back(reader.ReadBlock());
+        }
+
+        snapshot.orphans.clear();
+        count = reader.ReadU32();
+        for(uint32_t i = 0; i < count && reader.IsGood(); i++) {
+            snapshot.orphans.push_back(reader.ReadBlock());
+        }
+
+        snapshot.transactions.clear();
+        count = reader.ReadU32();
+        for(uint32_t i = 0; i < count && reader.IsGood(); i++) {
+            int nodeId = reader.ReadInt();
+            int transId = reader.ReadInt();
+            int height = reader.ReadInt();
+            int minerId = reader.ReadInt();
+            uint32_t position = reader.ReadU32();
+            snapshot.transactions.push_back(std::make_pair(TxId(nodeId, transId), std::make_pair(BlockId(height, minerId), position)));
+        }
+
+        return reader.IsGood();
+    }
+
+    void Blockchain::ApplySnapshot(BlockchainSnapshot &&snapshot) {
+        ForkChoice::ReorgCallback reorg = m_forkChoice.GetReorgCallback();
+        m_forkChoice.Clear();
+        m_forkChoice.SetReorgCallback(ForkChoice::ReorgCallback());
+        m_arena.Clear();
+        m_blocks.clear();
+        m_blockIndex.clear();
+        m_children.clear();
+        m_orphans.Clear();
+        m_seenBlocks.Reset(2 * (snapshot.blocks.size() + snapshot.orphans.size()));
+
+        m_checkpointDepth = snapshot.checkpointDepth;
+        m_dropStaleForks = snapshot.dropStaleForks;
+        m_checkpointHeight = snapshot.checkpointHeight;
+        m_finalizedMainChain = snapshot.finalizedMainChain;
+        m_prunedForkBlocks = snapshot.prunedForkBlocks;
+        m_prunedLongestFork = snapshot.prunedLongestFork;
+        m_finalizedMinedBlocks = snapshot.finalizedMinedBlocks;
+
+        for(auto &block : snapshot.blocks) {
+            BlockHandle handle = InsertBlock(std::move(block));
+            if(m_forkChoice.GetHeight(handle) < m_checkpointHeight) {
+                LedgerBlock &entry = m_arena.Get(handle);
+                ShareBlock(entry, Singleton<BlockStore>::Get()->InternHeader(*entry.block));
+            }
+        }
+        for(auto &orphan : snapshot.orphans) {
+            AddOrphan(std::move(orphan));
+        }
+
+        m_txIndex.clear();
+        for(auto const &tx : snapshot.transactions) {
+            TxLocation location = { GetBlockHandle(tx.second.first), tx.second.second };
+            if(location.block != INVALID_BLOCK_HANDLE) {
+                m_txIndex.insert(std::make_pair(tx.first, location));
+            }
+        }
+
+        m_totalBlocks = snapshot.totalBlocks;
+        m_forkChoice.SetReorgStatistics(snapshot.reorgs, snapshot.maxReorgDepth);
+        m_forkChoice.SetReorgCallback(reorg);
     }
 
     const char* GetMessageName(enum Messages m) {
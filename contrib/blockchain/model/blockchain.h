@@ -4,8 +4,15 @@
 
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include <algorithm>
+#include <istream>
+#include <ostream>
 #include "block.h"
+#include "block-arena.h"
+#include "fork-choice.h"
+#include "orphan-pool.h"
+#include "seen-filter.h"
 #include "ns3/address.h"
 
 namespace ns3 {
@@ -18,6 +25,29 @@ namespace ns3 {
     const char* GetBlockchainRegion(enum BlockchainRegion m);
     enum BlockchainRegion GetBlockchainEnum(uint32_t n);
 
+    /* Where a committed transaction sits in the ledger */
+    struct TxLocation {
+        BlockHandle block;
+        uint32_t position;
+    };
+
+    /* Ledger state read from a snapshot, not yet applied to a Blockchain */
+    struct BlockchainSnapshot {
+        int totalBlocks;
+        int reorgs;
+        int maxReorgDepth;
+        int checkpointDepth;
+        bool dropStaleForks;
+        int checkpointHeight;
+        int finalizedMainChain;
+        int prunedForkBlocks;
+        int prunedLongestFork;
+        std::unordered_map<int, int> finalizedMinedBlocks;
+        std::vector<Block> blocks;
+        std::vector<Block> orphans;
+        std::vector<std::pair<TxId, std::pair<BlockId, uint32_t>>> transactions;
+    };
+
     class Blockchain : public Block {
         public:
             Blockchain(void);
@@ -29,11 +59,33 @@ namespace ns3 {
 
             bool HasBlock(const Block &block) const;
             bool HasBlock(int height, int minerId) const;
+            bool HasBlock(const BlockId &id) const;
 
             Block ReturnBlock(int height, int minerId);
 
+            /*
+             * Handles stay valid while the block is in the ledger, so callers can
+             * keep them (or the reference from GetBlock) instead of copying blocks.
+             */
+            BlockHandle GetBlockHandle(int height, int minerId) const;
+            BlockHandle GetBlockHandle(const BlockId &id) const;
+            const Block& GetBlock(BlockHandle handle) const;
+
+            /*
+             * Blocks are shared with the ledgers of the other nodes (see BlockStore)
+             * without reception details. GetBlock and the pointer accessors return
+             * this node's view, which shares the transactions and carries its own.
+             */
+            std::shared_ptr<const Block> GetSharedBlock(BlockHandle handle) const;
+            double GetTimeReceived(BlockHandle handle) const;
+            Ipv4Address GetReceivedFromIpv4(BlockHandle handle) const;
+
             bool isOrphan(const Block &newBlock) const;
             bool isOrphan(int height, int minerId) const;
+            bool isOrphan(const BlockId &id) const;
+
+            /* Bloom filter probe: false means the block is neither in the ledger nor an orphan */
+            bool MayContainBlock(const BlockId &id) const;
 
             const Block* GetBlockPointer(const Block &newBlock) const;
             
@@ -43,18 +95,101 @@ namespace ns3 {
 
             const Block* GetParent(const Block &block);
 
+            /* Tip of the longest chain, first seen wins ties */
             const Block* GetCurrentTopBlock(void) const;
-
-            void AddBlock(const Block& newBlock);
+            BlockHandle GetBestTip(void) const;
+            const std::unordered_set<BlockHandle>& GetChainTips(void) const;
+
+            /*
+             * Skip pointers give the ancestor in O(log n) steps and the common
+             * ancestor in O(log^2 n), whatever the fork depth. Both return
+             * INVALID_BLOCK_HANDLE when the block is not in the ledger.
+             */
+            BlockHandle FindCommonAncestor(BlockHandle a, BlockHandle b) const;
+            BlockHandle GetAncestorAtHeight(BlockHandle block, int height) const;
+
+            /* Called whenever the best tip moves to a chain that does not extend the previous one */
+            void SetReorgCallback(ForkChoice::ReorgCallback reorg);
+            int GetReorgCount(void) const;
+
+            /* Adds the block and attaches every orphan that descends from it; returns the number attached */
+            int AddBlock(const Block& newBlock);
+            /* Same, but the transactions of newBlock are moved into the ledger instead of copied */
+            int AddBlock(Block&& newBlock);
 
             void AddOrphan(const Block& newBlock);
+            void AddOrphan(Block&& newBlock);
 
             void RemoveOrphan (const Block& newBlock);
+
+            /*
+             * Transaction index over every block in the ledger. When a transaction
+             * is in several forks, the location on the main chain is preferred.
+             */
+            bool HasTransaction(int nodeId, int transId) const;
+            bool HasTransaction(const TxId &id) const;
+            bool GetTransactionLocation(const TxId &id, TxLocation &location) const;
+            /* nullptr if unknown or if the block was pruned to its header */
+            const Transaction* FindTransaction(const TxId &id) const;
+            bool IsOnMainChain(BlockHandle handle) const;
+
+            /* Caps for the orphan pool, 0 means unbounded */
+            void SetOrphanLimits(uint32_t maxOrphans, uint64_t maxOrphanBytes);
+            uint64_t GetEvictedOrphans(void) const;
+
+            /*
+             * Blocks more than checkpointDepth below the best tip are final and keep
+             * only their header. With dropStaleForks, forks that branch off below the
+             * checkpoint are removed altogether. A depth of 0 disables pruning.
+             */
+            void SetPruning(int checkpointDepth, bool dropStaleForks);
+            int GetCheckpointHeight(void) const;
+
+            /* Fork statistics, including what pruning has already discarded */
+            int GetBlocksInForks(void) const;
+            int GetLongestFork(void) const;
+            int GetMinedBlocksInMainChain(int minerId) const;
+
+            /*
+             * Binary snapshot of the blocks, orphans, transaction index and pruning
+             * state. Restore replaces the whole ledger and returns false, leaving it
+             * untouched, if the stream does not hold a complete snapshot. The reorg
+             * callback is kept and is not fired for the restored blocks.
+             */
+            void Save(std::ostream &os) const;
+            bool Restore(std::istream &is);
+            /* Restore in two steps, for callers that read more state after the ledger */
+            static bool ReadSnapshot(std::istream &is, BlockchainSnapshot &snapshot);
+            void ApplySnapshot(BlockchainSnapshot &&snapshot);
         protected:
+            /* Returns the handle of the block, which may have been in the ledger already */
+            BlockHandle InsertBlock(Block&& newBlock);
+            /* Points entry at block, keeping the reception details of its view */
+            static void ShareBlock(LedgerBlock &entry, std::shared_ptr<const Block> block);
+            /* Links the blocks already in the ledger that descend from handle */
+            void AttachChildren(BlockHandle handle);
+            void Prune(void);
+            /* Removes a stale block and everything built on it, returns the height of the highest block removed */
+            int DropBranch(BlockHandle root);
+            void AddSeenBlock(const BlockId &id);
 
             int m_totalBlocks;
-            std::vector<std::vector<Block>> m_blocks;
-            std::vector<Block> m_orphans;
+            BlockArena m_arena;
+            std::vector<std::vector<BlockHandle>> m_blocks;        // handles per height, in arrival order
+            OrphanPool m_orphans;
+            ForkChoice m_forkChoice;
+            std::unordered_map<BlockId, BlockHandle> m_blockIndex;
+            std::unordered_map<BlockId, std::vector<BlockHandle>> m_children;      // parent id -> children
+            std::unordered_multimap<TxId, TxLocation> m_txIndex;
+            SeenFilter m_seenBlocks;                // ledger and orphan pool
+
+            int m_checkpointDepth;
+            bool m_dropStaleForks;
+            int m_checkpointHeight;             // heights below are final
+            int m_finalizedMainChain;           // main chain blocks below m_checkpointHeight
+            int m_prunedForkBlocks;
+            int m_prunedLongestFork;
+            std::unordered_map<int, int> m_finalizedMinedBlocks;   // minerId -> final main chain blocks
     };
 }
 
@@ -0,0 +1,244 @@
+#include <algorithm>
+#include "ns3/assert.h"
+
+#include "fork-choice.h"
+
+namespace ns3 {
+    ForkChoice::ForkChoice(void)
+        : m_bestTip(INVALID_BLOCK_HANDLE), m_reorgs(0), m_maxReorgDepth(0) {
+    }
+
+    ForkChoice::~ForkChoice(void) {}
+
+    void ForkChoice::AddBlock(BlockHandle handle, BlockHandle parent, int height, uint64_t weight, bool hasChildren) {
+        if(handle >= m_parent.size()) {
+            m_parent.resize(handle + 1, INVALID_BLOCK_HANDLE);
+            m_skip.resize(handle + 1, INVALID_BLOCK_HANDLE);
+            m_height.resize(handle + 1, 0);
+            m_weight.resize(handle + 1, 0);
+            m_blockWeight.resize(handle + 1, 0);
+        }
+
+        m_height[handle] = height;
+        m_blockWeight[handle] = weight;
+        Link(handle, parent);
+
+        if(hasChildren) {
+            return;
+        }
+        m_tips.insert(handle);
+        UpdateBestTip(handle);
+    }
+
+    void ForkChoice::AttachChild(BlockHandle child, BlockHandle parent) {
+        NS_ASSERT(child < m_parent.size() && parent < m_parent.size());
+        uint64_t previousWeight = m_weight[child];
+
+        Link(child, parent);
+        if(!IsTip(child)) {
+            return;
+        }
+
+        if(child == m_bestTip && m_weight[child] < previousWeight) {
+            // The best tip got lighter, another chain may now be heavier
+            for(auto const &tip : m_tips) {
+                if(m_weight[tip] > m_weight[m_bestTip] || (m_weight[tip] == m_weight[m_bestTip] && tip < m_bestTip)) {
+                    m_bestTip = tip;
+                }
+            }
+            return;
+        }
+        UpdateBestTip(child);
+    }
+
+    void ForkChoice::Link(BlockHandle handle, BlockHandle parent) {
+        int height = m_height[handle];
+
+        m_parent[handle] = parent;
+        m_skip[handle] = parent != INVALID_BLOCK_HANDLE ? GetAncestor(parent, GetSkipHeight(height)) : INVALID_BLOCK_HANDLE;
+        m_weight[handle] = (parent != INVALID_BLOCK_HANDLE ? m_weight[parent] : static_cast<uint64_t>(height)) + m_blockWeight[handle];
+
+        if(parent != INVALID_BLOCK_HANDLE) {
+            m_tips.erase(parent);
+        }
+    }
+
+    void ForkChoice::UpdateBestTip(BlockHandle handle) {
+        BlockHandle parent = m_parent[handle];
+
+        if(m_bestTip == INVALID_BLOCK_HANDLE) {
+            m_bestTip = handle;
+            return;
+        }
+        if(m_weight[handle] <= m_weight[m_bestTip]) {
+            return;
+        }
+
+        BlockHandle oldTip = m_bestTip;
+        m_bestTip = handle;
+
+        if(parent == oldTip) {
+            return;
+        }
+
+        BlockHandle ancestor = FindCommonAncestor(oldTip, handle);
+        int depth = m_height[oldTip] - (ancestor != INVALID_BLOCK_HANDLE ? m_height[ancestor] : -1);
+
+        if(depth > 0) {
+            m_reorgs++;
+            m_maxReorgDepth = std::max(m_maxReorgDepth, depth);
+            if(!m_reorgCallback.IsNull()) {
+                m_reorgCallback(oldTip, handle, depth);
+            }
+        }
+    }
+
+    void ForkChoice::RemoveBlock(BlockHandle handle) {
+        NS_ASSERT(handle < m_parent.size() && handle != m_bestTip);
+
+        m_tips.erase(handle);
+        m_parent[handle] = INVALID_BLOCK_HANDLE;
+        m_skip[handle] = INVALID_BLOCK_HANDLE;
+        m_height[handle] = 0;
+        m_weight[handle] = 0;
+        m_blockWeight[handle] = 0;
+    }
+
+    BlockHandle ForkChoice::GetBestTip(void) const {
+        return m_bestTip;
+    }
+
+    int ForkChoice::GetBestHeight(void) const {
+        return m_bestTip != INVALID_BLOCK_HANDLE ? m_height[m_bestTip] : -1;
+    }
+
+    uint64_t ForkChoice::GetBestWeight(void) const {
+        return m_bestTip != INVALID_BLOCK_HANDLE ? m_weight[m_bestTip] : 0;
+    }
+
+    const std::unordered_set<BlockHandle>& ForkChoice::GetTips(void) const {
+        return m_tips;
+    }
+
+    bool ForkChoice::IsTip(BlockHandle handle) const {
+        return m_tips.find(handle) != m_tips.end();
+    }
+
+    BlockHandle ForkChoice::GetParent(BlockHandle handle) const {
+        NS_ASSERT(handle < m_parent.size());
+        return m_parent[handle];
+    }
+
+    int ForkChoice::GetHeight(BlockHandle handle) const {
+        NS_ASSERT(handle < m_height.size());
+        return m_height[handle];
+    }
+
+    uint64_t ForkChoice::GetChainWeight(BlockHandle handle) const {
+        NS_ASSERT(handle < m_weight.size());
+        return m_weight[handle];
+    }
+
+    int ForkChoice::GetReorgCount(void) const {
+        return m_reorgs;
+    }
+
+    int ForkChoice::GetMaxReorgDepth(void) const {
+        return m_maxReorgDepth;
+    }
+
+    void ForkChoice::SetReorgCallback(ReorgCallback reorg) {
+        m_reorgCallback = reorg;
+    }
+
+    ForkChoice::ReorgCallback ForkChoice::GetReorgCallback(void) const {
+        return m_reorgCallback;
+    }
+
+    void ForkChoice::Clear(void) {
+        m_bestTip = INVALID_BLOCK_HANDLE;
+        m_reorgs = 0;
+        m_maxReorgDepth = 0;
+        m_parent.clear();
+        m_skip.clear();
+        m_height.clear();
+        m_weight.clear();
+        m_blockWeight.clear();
+        m_tips.clear();
+    }
+
+    void ForkChoice::SetReorgStatistics(int reorgs, int maxReorgDepth) {
+        m_reorgs = reorgs;
+        m_maxReorgDepth = maxReorgDepth;
+    }
+
+    BlockHandle ForkChoice::FindCommonAncestor(BlockHandle a, BlockHandle b) const {
+        if(a == INVALID_BLOCK_HANDLE || b == INVALID_BLOCK_HANDLE) {
+            return INVALID_BLOCK_HANDLE;
+        }
+
+        if(m_height[a] > m_height[b]) {
+            a = GetAncestor(a, m_height[b]);
+        } else if(m_height[b] > m_height[a]) {
+            b = GetAncestor(b, m_height[a]);
+        }
+
+        if(a == INVALID_BLOCK_HANDLE || b == INVALID_BLOCK_HANDLE || a == b) {
+            return a == b ? a : INVALID_BLOCK_HANDLE;
+        }
+
+        // The chains agree at every height up to the fork point, so binary search it
+        BlockHandle ancestor = INVALID_BLOCK_HANDLE;
+        int low = 0;
+        int high = m_height[a] - 1;
+        while(low <= high) {
+            int middle = low + (high - low) / 2;
+            BlockHandle candidate = GetAncestor(a, middle);
+
+            if(candidate != INVALID_BLOCK_HANDLE && candidate == GetAncestor(b, middle)) {
+                ancestor = candidate;
+                low = middle + 1;
+            } else {
+                high = middle - 1;
+            }
+        }
+        return ancestor;
+    }
+
+    BlockHandle ForkChoice::GetAncestor(BlockHandle handle, int height) const {
+        if(handle == INVALID_BLOCK_HANDLE || height < 0 || height > m_height[handle]) {
+            return INVALID_BLOCK_HANDLE;
+        }
+
+        BlockHandle walk = handle;
+        int heightWalk = m_height[handle];
+        while(walk != INVALID_BLOCK_HANDLE && heightWalk > height) {
+            int heightSkip = GetSkipHeight(heightWalk);
+            int heightSkipPrev = GetSkipHeight(heightWalk - 1);
+
+            // Only take the skip when the parent's skip would not get closer
+            if(m_skip[walk] != INVALID_BLOCK_HANDLE &&
+               (heightSkip == height || (heightSkip > height && !(heightSkipPrev < heightSkip - 2 && heightSkipPrev >= height)))) {
+                walk = m_skip[walk];
+                heightWalk = heightSkip;
+            } else {
+                walk = m_parent[walk];
+                heightWalk--;
+            }
+        }
+        return walk;
+    }
+
+    int ForkChoice::GetSkipHeight(int height) {
+        if(height < 2) {
+            return 0;
+        }
+
+        // Clearing the lowest set bits gives a mix of short and long jumps
+        if(height & 1) {
+            int odd = (height - 1) & (height - 2);
+            return (odd & (odd - 1)) + 1;
+        }
+        return height & (height - 1);
+    }
+}
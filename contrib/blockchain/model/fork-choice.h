@@ -0,0 +1,94 @@
+#ifndef FORK_CHOICE_H
+#define FORK_CHOICE_H
+
+#include <vector>
+#include <unordered_set>
+#include <stdint.h>
+
+#include "ns3/callback.h"
+
+#include "block-arena.h"
+
+namespace ns3 {
+    /*
+     * Incremental longest-chain fork choice over the blocks of a ledger. Every
+     * block carries the cumulative weight of the chain it ends; the set of chain
+     * tips and the best one are updated as blocks arrive, so the best tip is
+     * known without rescanning the ledger. Ties keep the first tip seen.
+     *
+     * Besides its parent, every block keeps a skip pointer to an ancestor
+     * further down (the pprev/pskip scheme of Bitcoin's block index), so
+     * ancestor queries take O(log n) steps. Common ancestor queries binary
+     * search the fork height with them, in O(log^2 n) steps.
+     */
+    class ForkChoice {
+        public:
+            /* old best tip, new best tip, number of blocks of the old chain abandoned */
+            typedef Callback<void, BlockHandle, BlockHandle, int> ReorgCallback;
+
+            ForkChoice(void);
+            virtual ~ForkChoice(void);
+
+            /*
+             * parent is INVALID_BLOCK_HANDLE when it is not in the ledger; the chain
+             * below such a block is then assumed to weigh one per height.
+             * hasChildren tells whether blocks extending this one are already known.
+             */
+            void AddBlock(BlockHandle handle, BlockHandle parent, int height, uint64_t weight, bool hasChildren);
+            /*
+             * Links a block added before its parent, recomputing its skip pointer and
+             * weight. The descendants of child must be attached after it, top down.
+             */
+            void AttachChild(BlockHandle child, BlockHandle parent);
+            /* Forgets a block that is not the best tip, e.g. when a stale fork is pruned */
+            void RemoveBlock(BlockHandle handle);
+
+            BlockHandle GetBestTip(void) const;
+            int GetBestHeight(void) const;
+            uint64_t GetBestWeight(void) const;
+
+            const std::unordered_set<BlockHandle>& GetTips(void) const;
+            bool IsTip(BlockHandle handle) const;
+
+            BlockHandle GetParent(BlockHandle handle) const;
+            int GetHeight(BlockHandle handle) const;
+            uint64_t GetChainWeight(BlockHandle handle) const;
+
+            int GetReorgCount(void) const;
+            int GetMaxReorgDepth(void) const;
+
+            void SetReorgCallback(ReorgCallback reorg);
+            ReorgCallback GetReorgCallback(void) const;
+
+            /* Forgets every block and the reorg counters, the callback is kept */
+            void Clear(void);
+            /* Used when the blocks are restored from a snapshot */
+            void SetReorgStatistics(int reorgs, int maxReorgDepth);
+
+            /* Common ancestor of two blocks, INVALID_BLOCK_HANDLE if their chains are disconnected */
+            BlockHandle FindCommonAncestor(BlockHandle a, BlockHandle b) const;
+            /* Ancestor of handle at the given height, INVALID_BLOCK_HANDLE if it is not in the ledger */
+            BlockHandle GetAncestor(BlockHandle handle, int height) const;
+
+        protected:
+            static int GetSkipHeight(int height);
+            void Link(BlockHandle handle, BlockHandle parent);
+            /* Makes handle, a tip with its final weight, the best tip if it is heavier */
+            void UpdateBestTip(BlockHandle handle);
+
+            BlockHandle m_bestTip;
+            int m_reorgs;
+            int m_maxReorgDepth;
+
+            std::vector<BlockHandle>            m_parent;   // indexed by handle
+            std::vector<BlockHandle>            m_skip;     // ancestor at GetSkipHeight(height)
+            std::vector<int>                    m_height;
+            std::vector<uint64_t>               m_weight;   // cumulative
+            std::vector<uint64_t>               m_blockWeight;
+            std::unordered_set<BlockHandle>     m_tips;
+
+            ReorgCallback m_reorgCallback;
+    };
+}
+
+#endif
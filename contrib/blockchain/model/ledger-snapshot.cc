@@ -0,0 +1,152 @@
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include "ledger-snapshot.h"
+
+namespace ns3 {
+    SnapshotWriter::SnapshotWriter(std::ostream &os) : m_os(os) {}
+
+    SnapshotWriter::~SnapshotWriter(void) {}
+
+    void SnapshotWriter::Write(const void *data, size_t size) {
+        m_os.write(static_cast<const char *>(data), size);
+    }
+
+    void SnapshotWriter::WriteU32(uint32_t value) {
+        Write(&value, sizeof(value));
+    }
+
+    void SnapshotWriter::WriteU64(uint64_t value) {
+        Write(&value, sizeof(value));
+    }
+
+    void SnapshotWriter::WriteInt(int value) {
+        WriteU32(static_cast<uint32_t>(value));
+    }
+
+    void SnapshotWriter::WriteDouble(double value) {
+        Write(&value, sizeof(value));
+    }
+
+    void SnapshotWriter::WriteBool(bool value) {
+        uint8_t byte = value ? 1 : 0;
+        Write(&byte, sizeof(byte));
+    }
+
+    void SnapshotWriter::WriteTransactions(const std::vector<Transaction> &transactions) {
+        WriteU32(transactions.size());
+        Write(transactions.data(), transactions.size() * sizeof(Transaction));
+    }
+
+    void SnapshotWriter::WriteReadWriteSets(const ReadWriteArena &readWriteSets) {
+        const std::vector<ReadWriteEntry> &entries = readWriteSets.GetEntries();
+        WriteU32(entries.size());
+        Write(entries.data(), entries.size() * sizeof(ReadWriteEntry));
+    }
+
+    void SnapshotWriter::WriteBlock(const Block &block) {
+        WriteInt(block.GetBlockHeight());
+        WriteInt(block.GetMinerId());
+        WriteInt(block.GetNonce());
+        WriteInt(block.GetParentBlockMinerId());
+        WriteInt(block.GetBlockSizeBytes());
+        WriteDouble(block.GetTimeStamp());
+        WriteDouble(block.GetTimeReceived());
+        WriteU32(block.GetReceivedFromIpv4().Get());
+        WriteTransactions(block.GetTransactions());
+        WriteReadWriteSets(block.GetReadWriteSets());
+    }
+
+    bool SnapshotWriter::IsGood(void) const {
+        return m_os.good();
+    }
+
+    SnapshotReader::SnapshotReader(std::istream &is) : m_is(is) {}
+
+    SnapshotReader::~SnapshotReader(void) {}
+
+    void SnapshotReader::Read(void *data, size_t size) {
+        if(!m_is.read(static_cast<char *>(data), size)) {
+            std::memset(data, 0, size);
+        }
+    }
+
+    uint32_t SnapshotReader::ReadU32(void) {
+        uint32_t value;
+        Read(&value, sizeof(value));
+        return value;
+    }
+
+    uint64_t SnapshotReader::ReadU64(void) {
+        uint64_t value;
+        Read(&value, sizeof(value));
+        return value;
+    }
+
+    int SnapshotReader::ReadInt(void) {
+        return static_cast<int>(ReadU32());
+    }
+
+    double SnapshotReader::ReadDouble(void) {
+        double value;
+        Read(&value, sizeof(value));
+        return value;
+    }
+
+    bool SnapshotReader::ReadBool(void) {
+        uint8_t byte;
+        Read(&byte, sizeof(byte));
+        return byte != 0;
+    }
+
+    template <typename T>
+    bool SnapshotReader::ReadRecords(std::vector<T> &records) {
+        uint32_t count = ReadU32();
+
+        records.clear();
+        while(records.size() < count && IsGood()) {
+            size_t first = records.size();
+            size_t chunk = std::min<size_t>(count - first, 4096);
+
+            records.resize(first + chunk);
+            Read(&records[first], chunk * sizeof(T));
+        }
+        return IsGood();
+    }
+
+    bool SnapshotReader::ReadTransactions(std::vector<Transaction> &transactions) {
+        return ReadRecords(transactions);
+    }
+
+    bool SnapshotReader::ReadReadWriteSets(ReadWriteArena &readWriteSets) {
+        std::vector<ReadWriteEntry> entries;
+        bool good = ReadRecords(entries);
+
+        readWriteSets.SetEntries(std::move(entries));
+        return good;
+    }
+
+    Block SnapshotReader::ReadBlock(void) {
+        int height = ReadInt();
+        int minerId = ReadInt();
+        int nonce = ReadInt();
+        int parentBlockMinerId = ReadInt();
+        int blockSizeBytes = ReadInt();
+        double timeStamp = ReadDouble();
+        double timeReceived = ReadDouble();
+        Ipv4Address receivedFromIpv4(ReadU32());
+        Block block(height, minerId, nonce, parentBlockMinerId, blockSizeBytes, timeStamp, timeReceived, receivedFromIpv4);
+        std::vector<Transaction> transactions;
+        ReadWriteArena readWriteSets;
+
+        ReadTransactions(transactions);
+        ReadReadWriteSets(readWriteSets);
+        block.SetTransactions(std::move(transactions), std::move(readWriteSets));
+        return block;
+    }
+
+    bool SnapshotReader::IsGood(void) const {
+        return m_is.good();
+    }
+}
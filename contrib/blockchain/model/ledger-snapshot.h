@@ -0,0 +1,69 @@
+#ifndef LEDGER_SNAPSHOT_H
+#define LEDGER_SNAPSHOT_H
+
+#include <istream>
+#include <ostream>
+#include <vector>
+#include <stdint.h>
+
+#include "block.h"
+
+namespace ns3 {
+    /*
+     * Binary encoding of ledger and node snapshots. Values are written in host
+     * byte order, so a snapshot is meant to be restored by the same build on the
+     * same kind of machine that took it.
+     */
+    class SnapshotWriter {
+        public:
+            SnapshotWriter(std::ostream &os);
+            virtual ~SnapshotWriter(void);
+
+            void WriteU32(uint32_t value);
+            void WriteU64(uint64_t value);
+            void WriteInt(int value);
+            void WriteDouble(double value);
+            void WriteBool(bool value);
+
+            /* Transactions are trivially copyable and are written as one block of memory */
+            void WriteTransactions(const std::vector<Transaction> &transactions);
+            void WriteReadWriteSets(const ReadWriteArena &readWriteSets);
+            void WriteBlock(const Block &block);
+
+            bool IsGood(void) const;
+
+        protected:
+            void Write(const void *data, size_t size);
+
+            std::ostream &m_os;
+    };
+
+    /* Reads what SnapshotWriter wrote; once a read fails every later read returns zeros */
+    class SnapshotReader {
+        public:
+            SnapshotReader(std::istream &is);
+            virtual ~SnapshotReader(void);
+
+            uint32_t ReadU32(void);
+            uint64_t ReadU64(void);
+            int ReadInt(void);
+            double ReadDouble(void);
+            bool ReadBool(void);
+
+            bool ReadTransactions(std::vector<Transaction> &transactions);
+            bool ReadReadWriteSets(ReadWriteArena &readWriteSets);
+            Block ReadBlock(void);
+
+            bool IsGood(void) const;
+
+        protected:
+            void Read(void *data, size_t size);
+            /* Reads a count and then that many records, grown in chunks so a corrupt count cannot allocate more than the stream holds */
+            template <typename T>
+            bool ReadRecords(std::vector<T> &records);
+
+            std::istream &m_is;
+    };
+}
+
+#endif
@@ -0,0 +1,172 @@
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+#include "orphan-pool.h"
+
+namespace ns3 {
+    OrphanPool::OrphanPool(void)
+        : m_maxOrphans(0), m_maxOrphanBytes(0), m_sizeBytes(0), m_evicted(0) {
+    }
+
+    OrphanPool::~OrphanPool(void) {}
+
+    void OrphanPool::SetMaxOrphans(uint32_t maxOrphans) {
+        m_maxOrphans = maxOrphans;
+        EvictOldest();
+    }
+
+    uint32_t OrphanPool::GetMaxOrphans(void) const {
+        return m_maxOrphans;
+    }
+
+    void OrphanPool::SetMaxOrphanBytes(uint64_t maxOrphanBytes) {
+        m_maxOrphanBytes = maxOrphanBytes;
+        EvictOldest();
+    }
+
+    uint64_t OrphanPool::GetMaxOrphanBytes(void) const {
+        return m_maxOrphanBytes;
+    }
+
+    int OrphanPool::GetSize(void) const {
+        return m_index.size();
+    }
+
+    uint64_t OrphanPool::GetSizeBytes(void) const {
+        return m_sizeBytes;
+    }
+
+    uint64_t OrphanPool::GetEvictedOrphans(void) const {
+        return m_evicted;
+    }
+
+    void OrphanPool::GetIds(std::vector<BlockId> &ids) const {
+        for(auto const &orphan : m_orphans) {
+            ids.push_back(orphan.GetBlockId());
+        }
+    }
+
+    bool OrphanPool::Has(int height, int minerId) const {
+        return m_index.find(BlockId(height, minerId)) != m_index.end();
+    }
+
+    const Block* OrphanPool::Get(int height, int minerId) const {
+        auto it = m_index.find(BlockId(height, minerId));
+
+        if(it == m_index.end()) {
+            return nullptr;
+        }
+        return &(*it->second);
+    }
+
+    bool OrphanPool::Add(const Block &block) {
+        return Add(Block(block));
+    }
+
+    bool OrphanPool::Add(Block &&block) {
+        BlockId key = block.GetBlockId();
+
+        if(m_index.find(key) != m_index.end()) {
+            return false;
+        }
+        // It would be evicted straight away, along with older orphans
+        if(m_maxOrphanBytes > 0 && static_cast<uint64_t>(block.GetBlockSizeBytes()) > m_maxOrphanBytes) {
+            return false;
+        }
+
+        m_waiting[block.GetParentBlockId()].push_back(key);
+        m_sizeBytes += block.GetBlockSizeBytes();
+        m_orphans.push_back(std::move(block));
+        m_index[key] = std::prev(m_orphans.end());
+
+        EvictOldest();
+        return true;
+    }
+
+    bool OrphanPool::Remove(int height, int minerId) {
+        auto it = m_index.find(BlockId(height, minerId));
+
+        if(it == m_index.end()) {
+            return false;
+        }
+        Erase(it->second);
+        return true;
+    }
+
+    void OrphanPool::Clear(void) {
+        m_orphans.clear();
+        m_index.clear();
+        m_waiting.clear();
+        m_sizeBytes = 0;
+    }
+
+    std::vector<const Block *> OrphanPool::GetWaitingOn(const Block &parent) const {
+        std::vector<const Block *> children;
+        auto adj = m_waiting.find(parent.GetBlockId());
+
+        if(adj == m_waiting.end()) {
+            return children;
+        }
+
+        children.reserve(adj->second.size());
+        for(auto const &key : adj->second) {
+            children.push_back(&(*m_index.find(key)->second));
+        }
+        return children;
+    }
+
+    std::vector<Block> OrphanPool::ReleaseDescendants(const Block &parent) {
+        std::vector<Block> released;
+        std::vector<BlockId> pending(1, parent.GetBlockId());
+
+        // Breadth first, so every released block comes after its parent
+        for(size_t next = 0; next < pending.size(); next++) {
+            auto adj = m_waiting.find(pending[next]);
+
+            if(adj == m_waiting.end()) {
+                continue;
+            }
+
+            std::vector<BlockId> children;
+            children.swap(adj->second);
+            m_waiting.erase(adj);
+
+            for(auto const &key : children) {
+                auto it = m_index.find(key);
+
+                m_sizeBytes -= it->second->GetBlockSizeBytes();
+                released.push_back(std::move(*it->second));
+                m_orphans.erase(it->second);
+                m_index.erase(it);
+                pending.push_back(key);
+            }
+        }
+        return released;
+    }
+
+    void OrphanPool::EvictOldest(void) {
+        while(!m_orphans.empty() &&
+              ((m_maxOrphans > 0 && m_index.size() > m_maxOrphans) ||
+               (m_maxOrphanBytes > 0 && m_sizeBytes > m_maxOrphanBytes))) {
+            Erase(m_orphans.begin());
+            m_evicted++;
+        }
+    }
+
+    void OrphanPool::Erase(std::list<Block>::iterator it) {
+        BlockId key = it->GetBlockId();
+        auto adj = m_waiting.find(it->GetParentBlockId());
+
+        if(adj != m_waiting.end()) {
+            adj->second.erase(std::remove(adj->second.begin(), adj->second.end(), key), adj->second.end());
+            if(adj->second.empty()) {
+                m_waiting.erase(adj);
+            }
+        }
+
+        m_sizeBytes -= it->GetBlockSizeBytes();
+        m_index.erase(key);
+        m_orphans.erase(it);
+    }
+}
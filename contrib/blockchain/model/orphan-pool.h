@@ -0,0 +1,68 @@
+#ifndef ORPHAN_POOL_H
+#define ORPHAN_POOL_H
+
+#include <list>
+#include <vector>
+#include <unordered_map>
+#include <stdint.h>
+
+#include "block.h"
+
+namespace ns3 {
+    /*
+     * Blocks whose parent is not in the ledger yet, indexed by the parent they
+     * are waiting for. The pool can be capped by count and/or bytes; when a cap
+     * is exceeded the oldest orphans are evicted first.
+     */
+    class OrphanPool {
+        public:
+            OrphanPool(void);
+            virtual ~OrphanPool(void);
+
+            /* 0 disables the corresponding cap */
+            void SetMaxOrphans(uint32_t maxOrphans);
+            uint32_t GetMaxOrphans(void) const;
+            void SetMaxOrphanBytes(uint64_t maxOrphanBytes);
+            uint64_t GetMaxOrphanBytes(void) const;
+
+            int GetSize(void) const;
+            uint64_t GetSizeBytes(void) const;
+            uint64_t GetEvictedOrphans(void) const;
+
+            /* Appends the ids of the orphans, oldest first */
+            void GetIds(std::vector<BlockId> &ids) const;
+            bool Has(int height, int minerId) const;
+            const Block* Get(int height, int minerId) const;
+
+            /* Returns false if the block is already in the pool or larger than the byte cap */
+            bool Add(const Block &block);
+            bool Add(Block &&block);
+            bool Remove(int height, int minerId);
+            /* Empties the pool; the limits and the eviction count are kept */
+            void Clear(void);
+
+            /* Orphans whose parent is the given block */
+            std::vector<const Block *> GetWaitingOn(const Block &parent) const;
+
+            /*
+             * Removes every orphan that descends from parent, directly or through
+             * other orphans, and returns them with each parent before its children.
+             */
+            std::vector<Block> ReleaseDescendants(const Block &parent);
+
+        protected:
+            void EvictOldest(void);
+            void Erase(std::list<Block>::iterator it);
+
+            uint32_t m_maxOrphans;
+            uint64_t m_maxOrphanBytes;
+            uint64_t m_sizeBytes;
+            uint64_t m_evicted;
+
+            std::list<Block>                                        m_orphans;  // oldest first
+            std::unordered_map<BlockId, std::list<Block>::iterator>  m_index;
+            std::unordered_map<BlockId, std::vector<BlockId>>        m_waiting;  // parent id -> orphan ids
+    };
+}
+
+#endif
@@ -0,0 +1,66 @@
+#include <cstring>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+#include "read-write-set.h"
+
+namespace ns3 {
+
+    static_assert(std::is_trivially_copyable<ReadWriteEntry>::value, "ReadWriteEntry must stay memcpy-able");
+
+    ReadWriteArena::ReadWriteArena(void) {}
+
+    ReadWriteArena::~ReadWriteArena(void) {}
+
+    uint32_t ReadWriteArena::Allocate(uint32_t count) {
+        uint32_t offset = m_entries.size();
+        m_entries.resize(offset + count);
+        return offset;
+    }
+
+    uint32_t ReadWriteArena::Append(const ReadWriteEntry *entries, uint32_t count) {
+        uint32_t offset = Allocate(count);
+        if(count > 0) {
+            std::memcpy(&m_entries[offset], entries, count * sizeof(ReadWriteEntry));
+        }
+        return offset;
+    }
+
+    ReadWriteEntry* ReadWriteArena::Get(uint32_t offset) {
+        return m_entries.data() + offset;
+    }
+
+    const ReadWriteEntry* ReadWriteArena::Get(uint32_t offset) const {
+        return m_entries.data() + offset;
+    }
+
+    bool ReadWriteArena::Contains(uint32_t offset, uint32_t count) const {
+        return offset <= m_entries.size() && count <= m_entries.size() - offset;
+    }
+
+    bool ReadWriteArena::Owns(const ReadWriteEntry *entries) const {
+        std::less<const ReadWriteEntry *> before;
+        return entries != nullptr && !before(entries, m_entries.data()) && before(entries, m_entries.data() + m_entries.size());
+    }
+
+    uint32_t ReadWriteArena::GetSize(void) const {
+        return m_entries.size();
+    }
+
+    void ReadWriteArena::Reserve(uint32_t entries) {
+        m_entries.reserve(entries);
+    }
+
+    void ReadWriteArena::Clear(void) {
+        std::vector<ReadWriteEntry>().swap(m_entries);
+    }
+
+    const std::vector<ReadWriteEntry>& ReadWriteArena::GetEntries(void) const {
+        return m_entries;
+    }
+
+    void ReadWriteArena::SetEntries(std::vector<ReadWriteEntry> &&entries) {
+        m_entries = std::move(entries);
+    }
+}
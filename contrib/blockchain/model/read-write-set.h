@@ -0,0 +1,50 @@
+#ifndef READ_WRITE_SET_H
+#define READ_WRITE_SET_H
+
+#include <vector>
+#include <stdint.h>
+
+namespace ns3 {
+    /* One key of a Fabric read or write set; trivially copyable like Transaction */
+    struct ReadWriteEntry {
+        uint64_t key;
+        uint32_t version;      // version read, or written by the transaction
+        uint32_t valueSize;    // bytes of the value, 0 for reads
+    };
+
+    /*
+     * Bump allocator for the read/write sets of one block. Every set is a run of
+     * consecutive entries addressed by its offset, so there is no allocation per
+     * key and growing the buffer does not invalidate what transactions refer to.
+     * Nothing is freed on its own; the whole arena goes with its block.
+     */
+    class ReadWriteArena {
+        public:
+            ReadWriteArena(void);
+            virtual ~ReadWriteArena(void);
+
+            /* Appends count zeroed entries and returns the offset of the first */
+            uint32_t Allocate(uint32_t count);
+            /* Appends a copy of count entries (from outside the arena), returns the offset of the first */
+            uint32_t Append(const ReadWriteEntry *entries, uint32_t count);
+
+            /* Valid until the next allocation */
+            ReadWriteEntry* Get(uint32_t offset);
+            const ReadWriteEntry* Get(uint32_t offset) const;
+            bool Contains(uint32_t offset, uint32_t count) const;
+            /* Whether entries points into this arena, where an allocation may move it */
+            bool Owns(const ReadWriteEntry *entries) const;
+
+            uint32_t GetSize(void) const;
+            void Reserve(uint32_t entries);
+            void Clear(void);
+
+            const std::vector<ReadWriteEntry>& GetEntries(void) const;
+            void SetEntries(std::vector<ReadWriteEntry> &&entries);
+
+        protected:
+            std::vector<ReadWriteEntry> m_entries;
+    };
+}
+
+#endif
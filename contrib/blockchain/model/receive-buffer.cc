@@ -0,0 +1,63 @@
+#include <algorithm>
+#include <cstring>
+
+#include "receive-buffer.h"
+
+namespace ns3 {
+    ReceiveBuffer::ReceiveBuffer(void) : m_begin(0), m_end(0), m_scanned(0) {}
+
+    ReceiveBuffer::~ReceiveBuffer(void) {}
+
+    uint8_t* ReceiveBuffer::Prepare(size_t size) {
+        if(m_data.size() - m_end < size) {
+            if(m_begin > 0) {
+                std::memmove(m_data.data(), m_data.data() + m_begin, m_end - m_begin);
+                m_end -= m_begin;
+                m_begin = 0;
+            }
+            if(m_data.size() - m_end < size) {
+                m_data.resize(std::max(2 * m_data.size(), m_end + size));
+            }
+        }
+        return reinterpret_cast<uint8_t *>(m_data.data() + m_end);
+    }
+
+    void ReceiveBuffer::Commit(size_t size) {
+        m_end += size;
+    }
+
+    char* ReceiveBuffer::GetData(void) {
+        return m_data.data() + m_begin;
+    }
+
+    const char* ReceiveBuffer::GetData(void) const {
+        return m_data.data() + m_begin;
+    }
+
+    size_t ReceiveBuffer::GetSize(void) const {
+        return m_end - m_begin;
+    }
+
+    void ReceiveBuffer::Consume(size_t size) {
+        m_begin += size;
+        m_scanned = 0;
+        if(m_begin == m_end) {
+            m_begin = 0;
+            m_end = 0;
+        }
+    }
+
+    void ReceiveBuffer::Clear(void) {
+        m_begin = 0;
+        m_end = 0;
+        m_scanned = 0;
+    }
+
+    size_t& ReceiveBuffer::GetScanned(void) {
+        return m_scanned;
+    }
+
+    size_t ReceiveBuffer::GetCapacity(void) const {
+        return m_data.size();
+    }
+}
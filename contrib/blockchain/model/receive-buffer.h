@@ -0,0 +1,44 @@
+#ifndef RECEIVE_BUFFER_H
+#define RECEIVE_BUFFER_H
+
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace ns3 {
+    /*
+     * Bytes received from one peer and not yet parsed. Packets are copied in
+     * once, at the end; frames are parsed in place at the front and consumed.
+     * The unconsumed tail is only moved to the front when room is needed, and
+     * the storage grows geometrically, so steady traffic does not allocate.
+     */
+    class ReceiveBuffer {
+        public:
+            ReceiveBuffer(void);
+            virtual ~ReceiveBuffer(void);
+
+            /* Room for size more bytes at the end; Commit() the bytes written there */
+            uint8_t* Prepare(size_t size);
+            void Commit(size_t size);
+
+            /* Unconsumed bytes, writable so that parsers may work in place */
+            char* GetData(void);
+            const char* GetData(void) const;
+            size_t GetSize(void) const;
+            void Consume(size_t size);
+            void Clear(void);
+
+            /* Unconsumed bytes already searched for the end of the first frame */
+            size_t& GetScanned(void);
+
+            size_t GetCapacity(void) const;
+
+        protected:
+            std::vector<char> m_data;
+            size_t m_begin;     // first unconsumed byte
+            size_t m_end;       // end of the received bytes
+            size_t m_scanned;   // bytes after m_begin without a frame end
+    };
+}
+
+#endif
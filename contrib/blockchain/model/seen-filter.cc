@@ -0,0 +1,59 @@
+#include "seen-filter.h"
+#include "block-id.h"
+
+namespace ns3 {
+    SeenFilter::SeenFilter(uint32_t expectedEntries) {
+        Reset(expectedEntries);
+    }
+
+    SeenFilter::~SeenFilter(void) {}
+
+    void SeenFilter::Insert(uint64_t key) {
+        uint64_t hash1 = MixId(key);
+        uint64_t hash2 = (hash1 >> 32) | 1;
+
+        for(uint32_t i = 0; i < m_hashes; i++) {
+            uint64_t bit = (hash1 + i * hash2) & m_mask;
+            m_bits[bit >> 6] |= static_cast<uint64_t>(1) << (bit & 63);
+        }
+        m_entries++;
+    }
+
+    bool SeenFilter::MayContain(uint64_t key) const {
+        uint64_t hash1 = MixId(key);
+        uint64_t hash2 = (hash1 >> 32) | 1;
+
+        for(uint32_t i = 0; i < m_hashes; i++) {
+            uint64_t bit = (hash1 + i * hash2) & m_mask;
+            if(!(m_bits[bit >> 6] & (static_cast<uint64_t>(1) << (bit & 63)))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool SeenFilter::NeedsRebuild(void) const {
+        return m_entries > m_capacity;
+    }
+
+    void SeenFilter::Reset(uint32_t expectedEntries) {
+        uint64_t bits = 64;
+
+        while(bits < static_cast<uint64_t>(expectedEntries) * m_bitsPerEntry) {
+            bits <<= 1;
+        }
+
+        m_capacity = bits / m_bitsPerEntry;
+        m_entries = 0;
+        m_mask = bits - 1;
+        m_bits.assign(bits / 64, 0);
+    }
+
+    uint32_t SeenFilter::GetEntries(void) const {
+        return m_entries;
+    }
+
+    uint32_t SeenFilter::GetCapacity(void) const {
+        return m_capacity;
+    }
+}
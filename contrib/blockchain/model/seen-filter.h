@@ -0,0 +1,43 @@
+#ifndef SEEN_FILTER_H
+#define SEEN_FILTER_H
+
+#include <vector>
+#include <stdint.h>
+
+namespace ns3 {
+    /*
+     * Bloom filter used as a fast negative path in front of exact "already
+     * seen" lookups. MayContain never returns false for a key that was
+     * inserted, so only possible hits need the exact structure.
+     *
+     * Keys are never removed; once more keys than the filter was sized for have
+     * been inserted, NeedsRebuild() turns true and the owner refills it from
+     * its exact structure with Reset() + Insert(), which also sheds stale keys.
+     */
+    class SeenFilter {
+        public:
+            SeenFilter(uint32_t expectedEntries = 1024);
+            virtual ~SeenFilter(void);
+
+            void Insert(uint64_t key);
+            bool MayContain(uint64_t key) const;
+
+            bool NeedsRebuild(void) const;
+            /* Empties the filter and resizes it for expectedEntries keys */
+            void Reset(uint32_t expectedEntries);
+
+            uint32_t GetEntries(void) const;
+            uint32_t GetCapacity(void) const;
+
+        protected:
+            static const uint32_t m_bitsPerEntry = 10;
+            static const uint32_t m_hashes = 7;     // about 1% false positives at capacity
+
+            uint32_t m_capacity;
+            uint32_t m_entries;
+            uint64_t m_mask;                        // number of bits - 1, a power of two
+            std::vector<uint64_t> m_bits;
+    };
+}
+
+#endif
@@ -0,0 +1,430 @@
+#include <cstring>
+#include "ns3/assert.h"
+
+#include "sha256.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define SHA256_X86 1
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+namespace ns3 {
+    static const uint32_t K[64] = {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+    };
+
+    static const uint32_t INITIAL_STATE[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+
+    static inline uint32_t ReadBE32(const uint8_t *p) {
+        return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+               (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+    }
+
+    static inline void WriteBE32(uint8_t *p, uint32_t x) {
+        p[0] = x >> 24;
+        p[1] = x >> 16;
+        p[2] = x >> 8;
+        p[3] = x;
+    }
+
+    /*
+     * The compression function is written once over a lane type V: uint32_t
+     * for the portable code, or a GCC vector of 4 or 8 words in which every
+     * lane hashes its own message. The vector versions are inlined into
+     * functions compiled for SSE4.1 and AVX2 and selected at run time.
+     */
+#ifdef SHA256_X86
+    typedef uint32_t Lanes4 __attribute__((vector_size(16)));
+    typedef uint32_t Lanes8 __attribute__((vector_size(32)));
+#define SHA256_INLINE inline __attribute__((always_inline))
+#else
+#define SHA256_INLINE inline
+#endif
+
+    static SHA256_INLINE void SetLane(uint32_t &v, int, uint32_t x) { v = x; }
+    static SHA256_INLINE uint32_t GetLane(const uint32_t &v, int) { return v; }
+    template<typename V> static SHA256_INLINE void SetLane(V &v, int lane, uint32_t x) { v[lane] = x; }
+    template<typename V> static SHA256_INLINE uint32_t GetLane(const V &v, int lane) { return v[lane]; }
+
+#define SHA256_ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+    template<typename V>
+    static SHA256_INLINE void Compress(V *state, const V *block) {
+        V w[64];
+        V a = state[0], b = state[1], c = state[2], d = state[3];
+        V e = state[4], f = state[5], g = state[6], h = state[7];
+
+        for(int t = 0; t < 16; t++) {
+            w[t] = block[t];
+        }
+        for(int t = 16; t < 64; t++) {
+            V s0 = SHA256_ROTR(w[t - 15], 7) ^ SHA256_ROTR(w[t - 15], 18) ^ (w[t - 15] >> 3);
+            V s1 = SHA256_ROTR(w[t - 2], 17) ^ SHA256_ROTR(w[t - 2], 19) ^ (w[t - 2] >> 10);
+            w[t] = w[t - 16] + s0 + w[t - 7] + s1;
+        }
+
+        for(int t = 0; t < 64; t++) {
+            V s1 = SHA256_ROTR(e, 6) ^ SHA256_ROTR(e, 11) ^ SHA256_ROTR(e, 25);
+            V ch = (e & f) ^ (~e & g);
+            V t1 = h + s1 + ch + K[t] + w[t];
+            V s0 = SHA256_ROTR(a, 2) ^ SHA256_ROTR(a, 13) ^ SHA256_ROTR(a, 22);
+            V maj = (a & b) ^ (a & c) ^ (b & c);
+            V t2 = s0 + maj;
+
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+
+        state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+        state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+    }
+
+    template<typename V>
+    static SHA256_INLINE void InitLanes(V *state) {
+        V zero = {};
+        for(int i = 0; i < 8; i++) {
+            state[i] = zero + INITIAL_STATE[i];
+        }
+    }
+
+    /* Hashes the 32 byte digests held in state once more and stores the result of every lane */
+    template<typename V, int N>
+    static SHA256_INLINE void RehashAndStore(V *state, uint8_t *out) {
+        V block[16];
+        V zero = {};
+
+        for(int i = 0; i < 8; i++) {
+            block[i] = state[i];
+        }
+        for(int i = 8; i < 16; i++) {
+            block[i] = zero;
+        }
+        block[8] = zero + 0x80000000;
+        block[15] = zero + 256;
+
+        InitLanes(state);
+        Compress(state, block);
+
+        for(int lane = 0; lane < N; lane++) {
+            for(int i = 0; i < 8; i++) {
+                WriteBE32(out + 32 * lane + 4 * i, GetLane(state[i], lane));
+            }
+        }
+    }
+
+    template<typename V, int N>
+    static SHA256_INLINE void DoubleHashShortLanes(uint8_t *out, const uint8_t *in, size_t size) {
+        V state[8];
+        V block[16];
+        uint8_t padded[64];
+
+        for(int lane = 0; lane < N; lane++) {
+            std::memset(padded, 0, sizeof(padded));
+            std::memcpy(padded, in + lane * size, size);
+            padded[size] = 0x80;
+            WriteBE32(padded + 60, size * 8);
+            for(int i = 0; i < 16; i++) {
+                SetLane(block[i], lane, ReadBE32(padded + 4 * i));
+            }
+        }
+
+        InitLanes(state);
+        Compress(state, block);
+        RehashAndStore<V, N>(state, out);
+    }
+
+    template<typename V, int N>
+    static SHA256_INLINE void DoubleHash64Lanes(uint8_t *out, const uint8_t *in) {
+        V state[8];
+        V block[16];
+
+        for(int lane = 0; lane < N; lane++) {
+            for(int i = 0; i < 16; i++) {
+                SetLane(block[i], lane, ReadBE32(in + 64 * lane + 4 * i));
+            }
+        }
+
+        InitLanes(state);
+        Compress(state, block);
+
+        // Padding block of a 64 byte message
+        V zero = {};
+        for(int i = 0; i < 16; i++) {
+            block[i] = zero;
+        }
+        block[0] = zero + 0x80000000;
+        block[15] = zero + 512;
+        Compress(state, block);
+
+        RehashAndStore<V, N>(state, out);
+    }
+
+    static void CompressPortable(uint32_t *state, const uint8_t *data, size_t blocks) {
+        for(; blocks > 0; blocks--, data += 64) {
+            uint32_t block[16];
+            for(int i = 0; i < 16; i++) {
+                block[i] = ReadBE32(data + 4 * i);
+            }
+            Compress<uint32_t>(state, block);
+        }
+    }
+
+#ifdef SHA256_X86
+    __attribute__((target("sse4.1")))
+    static void DoubleHashShortSse4(uint8_t *out, const uint8_t *in, size_t size) {
+        DoubleHashShortLanes<Lanes4, 4>(out, in, size);
+    }
+
+    __attribute__((target("sse4.1")))
+    static void DoubleHash64Sse4(uint8_t *out, const uint8_t *in) {
+        DoubleHash64Lanes<Lanes4, 4>(out, in);
+    }
+
+    __attribute__((target("avx2")))
+    static void DoubleHashShortAvx2(uint8_t *out, const uint8_t *in, size_t size) {
+        DoubleHashShortLanes<Lanes8, 8>(out, in, size);
+    }
+
+    __attribute__((target("avx2")))
+    static void DoubleHash64Avx2(uint8_t *out, const uint8_t *in) {
+        DoubleHash64Lanes<Lanes8, 8>(out, in);
+    }
+
+    /* One message at a time with the SHA extensions, four rounds per step */
+    __attribute__((target("sha,sse4.1")))
+    static void CompressShaNi(uint32_t *state, const uint8_t *data, size_t blocks) {
+        const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+        __m128i tmp = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&state[0]));
+        __m128i state1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&state[4]));
+
+        tmp = _mm_shuffle_epi32(tmp, 0xb1);                  // CDAB
+        state1 = _mm_shuffle_epi32(state1, 0x1b);            // EFGH
+        __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);    // ABEF
+        state1 = _mm_blend_epi16(state1, tmp, 0xf0);         // CDGH
+
+        for(; blocks > 0; blocks--, data += 64) {
+            __m128i abefSave = state0;
+            __m128i cdghSave = state1;
+            __m128i msgs[4];
+
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 8
+#pragma GCC unroll 16
+#endif
+            for(int i = 0; i < 16; i++) {
+                if(i < 4) {
+                    msgs[i] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 16 * i)), mask);
+                } else {
+                    // W[t-16] + s0(W[t-15]) + W[t-7], then s1(W[t-2]) is added by msg2
+                    __m128i next = _mm_sha256msg1_epu32(msgs[i % 4], msgs[(i + 1) % 4]);
+                    next = _mm_add_epi32(next, _mm_alignr_epi8(msgs[(i + 3) % 4], msgs[(i + 2) % 4], 4));
+                    msgs[i % 4] = _mm_sha256msg2_epu32(next, msgs[(i + 3) % 4]);
+                }
+
+                __m128i msg = _mm_add_epi32(msgs[i % 4], _mm_loadu_si128(reinterpret_cast<const __m128i *>(&K[4 * i])));
+                state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+                msg = _mm_shuffle_epi32(msg, 0x0e);
+                state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+            }
+
+            state0 = _mm_add_epi32(state0, abefSave);
+            state1 = _mm_add_epi32(state1, cdghSave);
+        }
+
+        tmp = _mm_shuffle_epi32(state0, 0x1b);               // FEBA
+        state1 = _mm_shuffle_epi32(state1, 0xb1);            // DCHG
+        state0 = _mm_blend_epi16(tmp, state1, 0xf0);         // DCBA
+        state1 = _mm_alignr_epi8(state1, tmp, 8);            // HGFE
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(&state[0]), state0);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(&state[4]), state1);
+    }
+#endif
+
+    static bool DetectSupport(Sha256::Implementation implementation) {
+        switch(implementation) {
+            case Sha256::PORTABLE:
+                return true;
+#ifdef SHA256_X86
+            case Sha256::SSE4:
+                return __builtin_cpu_supports("sse4.1");
+            case Sha256::AVX2:
+                return __builtin_cpu_supports("avx2");
+            case Sha256::SHANI: {
+                unsigned int eax, ebx, ecx, edx;
+                if(!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+                    return false;
+                }
+                return (ebx & (1u << 29)) && __builtin_cpu_supports("sse4.1");
+            }
+#endif
+            default:
+                return false;
+        }
+    }
+
+    static Sha256::Implementation DetectBest(void) {
+        const Sha256::Implementation preferred[] = { Sha256::SHANI, Sha256::AVX2, Sha256::SSE4 };
+
+        for(auto implementation : preferred) {
+            if(DetectSupport(implementation)) {
+                return implementation;
+            }
+        }
+        return Sha256::PORTABLE;
+    }
+
+    static Sha256::Implementation &CurrentImplementation(void) {
+        static Sha256::Implementation current = DetectBest();
+        return current;
+    }
+
+    /* Eight lanes of AVX2 beat the SHA extensions one message at a time */
+    static bool UseEightLanes(Sha256::Implementation implementation) {
+        static bool avx2 = DetectSupport(Sha256::AVX2);
+        return implementation == Sha256::AVX2 || (implementation == Sha256::SHANI && avx2);
+    }
+
+    typedef void (*CompressFunction)(uint32_t *state, const uint8_t *data, size_t blocks);
+
+    static CompressFunction GetCompress(void) {
+#ifdef SHA256_X86
+        if(CurrentImplementation() == Sha256::SHANI) {
+            return CompressShaNi;
+        }
+#endif
+        return CompressPortable;
+    }
+
+    std::string HashToString(const Hash256 &hash) {
+        static const char digits[] = "0123456789abcdef";
+        std::string hex;
+
+        hex.reserve(64);
+        for(auto byte : hash) {
+            hex.push_back(digits[byte >> 4]);
+            hex.push_back(digits[byte & 15]);
+        }
+        return hex;
+    }
+
+    void Sha256::Hash(const uint8_t *data, size_t size, Hash256 &out) {
+        CompressFunction compress = GetCompress();
+        uint32_t state[8];
+        uint8_t tail[128];
+        size_t full = size / 64;
+        size_t rest = size - full * 64;
+        size_t tailBlocks = rest + 9 > 64 ? 2 : 1;
+        uint64_t bits = static_cast<uint64_t>(size) * 8;
+
+        std::memcpy(state, INITIAL_STATE, sizeof(state));
+        compress(state, data, full);
+
+        std::memset(tail, 0, sizeof(tail));
+        std::memcpy(tail, data + full * 64, rest);
+        tail[rest] = 0x80;
+        WriteBE32(tail + tailBlocks * 64 - 8, bits >> 32);
+        WriteBE32(tail + tailBlocks * 64 - 4, bits);
+        compress(state, tail, tailBlocks);
+
+        for(int i = 0; i < 8; i++) {
+            WriteBE32(out.data() + 4 * i, state[i]);
+        }
+    }
+
+    void Sha256::DoubleHash(const uint8_t *data, size_t size, Hash256 &out) {
+        Hash256 first;
+        Hash(data, size, first);
+        Hash(first.data(), first.size(), out);
+    }
+
+    void Sha256::DoubleHashShort(uint8_t *out, const uint8_t *in, size_t count, size_t size) {
+        size_t done = 0;
+
+        NS_ASSERT(size <= 55);
+#ifdef SHA256_X86
+        Implementation implementation = CurrentImplementation();
+        if(UseEightLanes(implementation)) {
+            for(; done + 8 <= count; done += 8) {
+                DoubleHashShortAvx2(out + 32 * done, in + size * done, size);
+            }
+        }
+        if(implementation == AVX2 || implementation == SSE4) {
+            for(; done + 4 <= count; done += 4) {
+                DoubleHashShortSse4(out + 32 * done, in + size * done, size);
+            }
+        }
+#endif
+        for(; done < count; done++) {
+            Hash256 hash;
+            DoubleHash(in + size * done, size, hash);
+            std::memcpy(out + 32 * done, hash.data(), hash.size());
+        }
+    }
+
+    void Sha256::DoubleHash64(uint8_t *out, const uint8_t *in, size_t count) {
+        size_t done = 0;
+
+        // Every batch reads all its inputs before writing, and outputs are half
+        // the size of inputs, so writing in place never overwrites unread input
+#ifdef SHA256_X86
+        Implementation implementation = CurrentImplementation();
+        if(UseEightLanes(implementation)) {
+            for(; done + 8 <= count; done += 8) {
+                DoubleHash64Avx2(out + 32 * done, in + 64 * done);
+            }
+        }
+        if(implementation == AVX2 || implementation == SSE4) {
+            for(; done + 4 <= count; done += 4) {
+                DoubleHash64Sse4(out + 32 * done, in + 64 * done);
+            }
+        }
+#endif
+        for(; done < count; done++) {
+            Hash256 hash;
+            DoubleHash(in + 64 * done, 64, hash);
+            std::memcpy(out + 32 * done, hash.data(), hash.size());
+        }
+    }
+
+    uint64_t Sha256::GetCompressions(uint64_t size) {
+        return (size + 9 + 63) / 64;
+    }
+
+    Sha256::Implementation Sha256::GetImplementation(void) {
+        return CurrentImplementation();
+    }
+
+    void Sha256::SetImplementation(Implementation implementation) {
+        CurrentImplementation() = IsSupported(implementation) ? implementation : DetectBest();
+    }
+
+    bool Sha256::IsSupported(Implementation implementation) {
+        return DetectSupport(implementation);
+    }
+
+    const char* Sha256::GetImplementationName(Implementation implementation) {
+        switch(implementation) {
+            case PORTABLE: return "portable";
+            case SSE4: return "sse4.1";
+            case AVX2: return "avx2";
+            case SHANI: return "sha-ni";
+            default: return "unknown";
+        }
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef SHA256_H
+#define SHA256_H
+
+#include <array>
+#include <string>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace ns3 {
+    typedef std::array<uint8_t, 32> Hash256;
+
+    std::string HashToString(const Hash256 &hash);
+
+    /*
+     * SHA-256 with the batched double hashes needed by Merkle trees. Batches
+     * are hashed several messages at a time, 4 lanes with SSE4.1 and 8 with
+     * AVX2. With the SHA extensions single messages use them, while full
+     * batches of 8 still go through AVX2 when present, as that is faster.
+     * The portable code is used on every other CPU.
+     */
+    class Sha256 {
+        public:
+            enum Implementation {
+                PORTABLE,
+                SSE4,
+                AVX2,
+                SHANI
+            };
+
+            static void Hash(const uint8_t *data, size_t size, Hash256 &out);
+            static void DoubleHash(const uint8_t *data, size_t size, Hash256 &out);
+
+            /*
+             * out[i] = SHA256(SHA256(message i)) for count messages of size bytes
+             * (at most 55) stored back to back.
+             */
+            static void DoubleHashShort(uint8_t *out, const uint8_t *in, size_t count, size_t size);
+            /* Same for 64 byte messages, i.e. two child hashes of a Merkle tree; out may alias in */
+            static void DoubleHash64(uint8_t *out, const uint8_t *in, size_t count);
+
+            /* SHA-256 compressions needed to hash a message of size bytes */
+            static uint64_t GetCompressions(uint64_t size);
+
+            /* Best implementation the CPU supports, unless overridden */
+            static Implementation GetImplementation(void);
+            /* Falls back to the best supported implementation if the CPU lacks the requested one */
+            static void SetImplementation(Implementation implementation);
+            static bool IsSupported(Implementation implementation);
+            static const char* GetImplementationName(Implementation implementation);
+    };
+}
+
+#endif
@@ -0,0 +1,169 @@
+#include <algorithm>
+#include "ns3/assert.h"
+
+#include "transaction-pool.h"
+
+namespace ns3 {
+    TransactionPool::TransactionPool(void) {}
+
+    TransactionPool::~TransactionPool(void) {}
+
+    TransactionSlot TransactionPool::Add(const Transaction &transaction, uint8_t stages) {
+        NS_ASSERT(stages != 0);
+
+        TxId id = transaction.GetTxId();
+        TransactionSlot slot = Find(id);
+        bool created = slot == INVALID_TRANSACTION_SLOT;
+
+        if(created) {
+            if(!m_free.empty()) {
+                slot = m_free.back();
+                m_free.pop_back();
+            } else {
+                slot = m_ids.size();
+                m_ids.push_back(id);
+                m_timeStamps.push_back(0);
+                m_sizes.push_back(0);
+                m_executions.push_back(0);
+                m_validated.push_back(0);
+                m_stages.push_back(0);
+                m_replies.push_back(std::vector<int32_t>());
+            }
+            m_index[id] = slot;
+        }
+
+        // Replies and results must not overwrite the node's own copy
+        if(created || (stages & (RECEIVED | NOT_VALIDATED))) {
+            m_ids[slot] = id;
+            m_timeStamps[slot] = transaction.GetTransTimeStamp();
+            m_sizes[slot] = transaction.GetTransSizeByte();
+            m_executions[slot] = transaction.GetExecution();
+            m_validated[slot] = transaction.IsValidated();
+        }
+        if(stages & REPLY) {
+            AddReply(slot, transaction.GetExecution());
+        }
+        m_stages[slot] |= stages;
+        return slot;
+    }
+
+    void TransactionPool::Remove(const TxId &id) {
+        TransactionSlot slot = Find(id);
+
+        if(slot != INVALID_TRANSACTION_SLOT) {
+            Release(slot);
+        }
+    }
+
+    void TransactionPool::Clear(void) {
+        m_ids.clear();
+        m_timeStamps.clear();
+        m_sizes.clear();
+        m_executions.clear();
+        m_validated.clear();
+        m_stages.clear();
+        m_replies.clear();
+        m_index.clear();
+        m_free.clear();
+    }
+
+    TransactionSlot TransactionPool::Find(const TxId &id) const {
+        auto it = m_index.find(id);
+        return it != m_index.end() ? it->second : INVALID_TRANSACTION_SLOT;
+    }
+
+    bool TransactionPool::Has(const TxId &id) const {
+        return m_index.find(id) != m_index.end();
+    }
+
+    bool TransactionPool::Has(const TxId &id, uint8_t stage) const {
+        TransactionSlot slot = Find(id);
+        return slot != INVALID_TRANSACTION_SLOT && (m_stages[slot] & stage);
+    }
+
+    bool TransactionPool::HasReply(const TxId &id, int execution) const {
+        TransactionSlot slot = Find(id);
+
+        if(slot == INVALID_TRANSACTION_SLOT || !(m_stages[slot] & REPLY)) {
+            return false;
+        }
+        return std::find(m_replies[slot].begin(), m_replies[slot].end(), execution) != m_replies[slot].end();
+    }
+
+    void TransactionPool::SetStage(const TxId &id, uint8_t stage) {
+        TransactionSlot slot = Find(id);
+
+        NS_ASSERT(slot != INVALID_TRANSACTION_SLOT);
+        if(stage & REPLY) {
+            AddReply(slot, m_executions[slot]);
+        }
+        m_stages[slot] |= stage;
+    }
+
+    void TransactionPool::ClearStage(const TxId &id, uint8_t stage) {
+        TransactionSlot slot = Find(id);
+
+        if(slot == INVALID_TRANSACTION_SLOT) {
+            return;
+        }
+        m_stages[slot] &= ~stage;
+        if(stage & REPLY) {
+            m_replies[slot].clear();
+        }
+        if(m_stages[slot] == 0) {
+            Release(slot);
+        }
+    }
+
+    uint8_t TransactionPool::GetStages(TransactionSlot slot) const {
+        NS_ASSERT(slot < m_stages.size());
+        return m_stages[slot];
+    }
+
+    Transaction TransactionPool::Get(TransactionSlot slot) const {
+        NS_ASSERT(slot < m_stages.size() && m_stages[slot] != 0);
+
+        Transaction transaction(m_ids[slot].GetNodeId(), m_ids[slot].GetTransId(), m_timeStamps[slot]);
+        transaction.SetTransSizeByte(m_sizes[slot]);
+        transaction.SetExecution(m_executions[slot]);
+        if(m_validated[slot]) {
+            transaction.SetValidation();
+        }
+        return transaction;
+    }
+
+    int TransactionPool::GetExecution(TransactionSlot slot) const {
+        NS_ASSERT(slot < m_executions.size());
+        return m_executions[slot];
+    }
+
+    bool TransactionPool::IsValidated(TransactionSlot slot) const {
+        NS_ASSERT(slot < m_validated.size());
+        return m_validated[slot];
+    }
+
+    void TransactionPool::GetTransactions(uint8_t stage, std::vector<Transaction> &transactions) const {
+        for(TransactionSlot slot = 0; slot < m_stages.size(); slot++) {
+            if(m_stages[slot] & stage) {
+                transactions.push_back(Get(slot));
+            }
+        }
+    }
+
+    uint32_t TransactionPool::GetSize(void) const {
+        return m_index.size();
+    }
+
+    void TransactionPool::Release(TransactionSlot slot) {
+        m_index.erase(m_ids[slot]);
+        m_stages[slot] = 0;
+        m_replies[slot].clear();
+        m_free.push_back(slot);
+    }
+
+    void TransactionPool::AddReply(TransactionSlot slot, int32_t execution) {
+        if(std::find(m_replies[slot].begin(), m_replies[slot].end(), execution) == m_replies[slot].end()) {
+            m_replies[slot].push_back(execution);
+        }
+    }
+}
@@ -0,0 +1,84 @@
+#ifndef TRANSACTION_POOL_H
+#define TRANSACTION_POOL_H
+
+#include <vector>
+#include <unordered_map>
+#include <stdint.h>
+
+#include "transaction.h"
+
+namespace ns3 {
+    typedef uint32_t TransactionSlot;
+    const TransactionSlot INVALID_TRANSACTION_SLOT = 0xffffffff;
+
+    /*
+     * Mempool of a node. Every transaction the node knows about has one slot,
+     * found through a TxId index, and a set of stage bits telling which of the
+     * node's lists it belongs to. Fields are stored column by column, so moving
+     * a transaction from one stage to another only flips bits.
+     *
+     * The fields of a slot describe the transaction as the node received it:
+     * they are set when the slot is created and by RECEIVED or NOT_VALIDATED
+     * adds only. Replies can come from several executors, so the REPLY stage
+     * also keeps the executor of every reply.
+     */
+    class TransactionPool {
+        public:
+            enum Stage {
+                RECEIVED            = 1 << 0,
+                NOT_VALIDATED       = 1 << 1,
+                REPLY               = 1 << 2,
+                MESSAGE             = 1 << 3,
+                RESULT              = 1 << 4,
+                WAITING_ENDORSERS   = 1 << 5
+            };
+
+            TransactionPool(void);
+            virtual ~TransactionPool(void);
+
+            /* Adds the transaction or, if it is already known, adds the stages (see above); returns its slot */
+            TransactionSlot Add(const Transaction &transaction, uint8_t stages);
+            void Remove(const TxId &id);
+            void Clear(void);
+
+            TransactionSlot Find(const TxId &id) const;
+            bool Has(const TxId &id) const;
+            bool Has(const TxId &id, uint8_t stage) const;
+            /* Whether a reply executed by execution was recorded */
+            bool HasReply(const TxId &id, int execution) const;
+
+            /*
+             * Setting REPLY records the executor of the slot as a reply, clearing
+             * it forgets every reply. A slot is released once it is in no stage at all.
+             */
+            void SetStage(const TxId &id, uint8_t stage);
+            void ClearStage(const TxId &id, uint8_t stage);
+            uint8_t GetStages(TransactionSlot slot) const;
+
+            Transaction Get(TransactionSlot slot) const;
+            int GetExecution(TransactionSlot slot) const;
+            bool IsValidated(TransactionSlot slot) const;
+
+            /* Transactions in the given stage, in slot order */
+            void GetTransactions(uint8_t stage, std::vector<Transaction> &transactions) const;
+
+            uint32_t GetSize(void) const;
+
+        protected:
+            void Release(TransactionSlot slot);
+            void AddReply(TransactionSlot slot, int32_t execution);
+
+            std::vector<TxId>       m_ids;              // indexed by slot
+            std::vector<double>     m_timeStamps;
+            std::vector<uint32_t>   m_sizes;
+            std::vector<int32_t>    m_executions;
+            std::vector<uint8_t>    m_validated;
+            std::vector<uint8_t>    m_stages;           // 0 for a free slot
+            std::vector<std::vector<int32_t>>   m_replies;  // executors of the replies
+
+            std::unordered_map<TxId, TransactionSlot>   m_index;
+            std::vector<TransactionSlot>                m_free;
+    };
+}
+
+#endif
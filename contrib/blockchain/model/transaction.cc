@@ -1,36 +1,38 @@
+#include <type_traits>
+
 #include "transaction.h"
 
 namespace ns3 {
 
-    Transaction::Transaction(int nodeId, int transId, double timeStamp) {
-        m_nodeId = nodeId;
-        m_transId = transId;
-        m_timeStamp = timeStamp;
-        m_transSizeByte = 100;
-        m_validatation = false;
-        m_execution = 0;
-    }
+    static_assert(std::is_trivially_copyable<Transaction>::value, "Transaction must stay memcpy-able");
+    static_assert(sizeof(Transaction) == 32, "Transaction is expected to pack in 32 bytes");
 
-    Transaction::Transaction() {
-        Transaction(0,0,0);
+    Transaction::Transaction(int nodeId, int transId, double timeStamp)
+        : m_id(nodeId, transId), m_timeStamp(timeStamp), m_transSizeByte(100), m_execution(0), m_flags(0),
+          m_readWriteSetOffset(0), m_readCount(0), m_writeCount(0) {
     }
 
-    Transaction::~Transaction(){}
+    Transaction::Transaction() : Transaction(0, 0, 0) {
+    }
 
     int Transaction::GetTransactionNodeId(void) const {
-        return m_nodeId;
+        return m_id.GetNodeId();
     }
 
     void Transaction::SetTransactionNodeId(int nodeId) {
-        m_nodeId = nodeId;
+        m_id = TxId(nodeId, m_id.GetTransId());
     }
 
     int Transaction::GetTransactionId(void) const {
-        return m_transId;
+        return m_id.GetTransId();
     }
 
     void Transaction::SetTransactionId(int id) {
-        m_transId = id;
+        m_id = TxId(m_id.GetNodeId(), id);
+    }
+
+    TxId Transaction::GetTxId(void) const {
+        return m_id;
     }
 
     int Transaction::GetTransSizeByte(void) const {
@@ -48,11 +50,11 @@ namespace ns3 {
     }
 
     bool Transaction::IsValidated(void) const {
-        return m_validatation;
+        return m_flags & VALIDATED;
     }
 
     void Transaction::SetValidation() {
-        m_validatation = true;
+        m_flags |= VALIDATED;
     }
 
     int Transaction::GetExecution(void) const {
@@ -62,19 +64,34 @@ namespace ns3 {
         m_execution = endoerserId;
     }
 
-    Transaction& Transaction::operator = (const Transaction &transSource) {
-        m_nodeId = transSource.m_nodeId;
-        m_transId = transSource.m_transId;
-        m_timeStamp = transSource.m_timeStamp;
-        m_transSizeByte = transSource.m_transSizeByte;
-        m_validatation = transSource.m_validatation;
-        m_execution = transSource.m_execution;
+    bool Transaction::HasReadWriteSet(void) const {
+        return m_readCount + m_writeCount > 0;
+    }
+
+    uint32_t Transaction::GetReadWriteSetOffset(void) const {
+        return m_readWriteSetOffset;
+    }
+
+    int Transaction::GetReadCount(void) const {
+        return m_readCount;
+    }
+
+    int Transaction::GetWriteCount(void) const {
+        return m_writeCount;
+    }
+
+    void Transaction::SetReadWriteSet(uint32_t offset, uint16_t readCount, uint16_t writeCount) {
+        m_readWriteSetOffset = offset;
+        m_readCount = readCount;
+        m_writeCount = writeCount;
+    }
 
-        return *this;
+    void Transaction::ClearReadWriteSet(void) {
+        SetReadWriteSet(0, 0, 0);
     }
 
     bool operator == (const Transaction &trans1, const Transaction &trans2) {
-        if(trans1.GetTransactionNodeId() == trans2.GetTransactionNodeId() && trans1.GetTransactionId() == trans2.GetTransactionId()) {
+        if(trans1.m_id == trans2.m_id) {
             return true;
         } else {
             return false;
@@ -1,18 +1,29 @@
 #ifndef TRANSACTION_H
 #define TRANSACTION_H
 
+#include <stdint.h>
+
+#include "block-id.h"
+
 namespace ns3 {
+    /*
+     * Transaction record, packed in 32 bytes and trivially copyable (no virtual
+     * functions, no user copy or destructor) so that mempools and blocks can
+     * store it contiguously and copy it in bulk with memcpy.
+     */
     class Transaction {
         public:
             Transaction(int nodeId, int transId, double timeStamp);
             Transaction();
-            virtual ~Transaction(void);
+
             int GetTransactionNodeId(void) const;
             void SetTransactionNodeId(int nodeId);
 
             int GetTransactionId(void) const;
             void SetTransactionId(int id);
 
+            TxId GetTxId(void) const;
+
             int GetTransSizeByte(void) const;
             void SetTransSizeByte(int transSizeByte);
 
@@ -22,21 +33,37 @@ namespace ns3 {
             bool IsValidated(void) const;
             void SetValidation();
 
+            /* Id of the endorser that executed the transaction, kept in 24 bits */
             int GetExecution(void) const;
             void SetExecution(int endoerserId);
 
-            Transaction& operator = (const Transaction &transSource);
+            /*
+             * Read/write set of the transaction: its reads then its writes, stored
+             * from the offset on in the ReadWriteArena of the block holding it.
+             */
+            bool HasReadWriteSet(void) const;
+            uint32_t GetReadWriteSetOffset(void) const;
+            int GetReadCount(void) const;
+            int GetWriteCount(void) const;
+            void SetReadWriteSet(uint32_t offset, uint16_t readCount, uint16_t writeCount);
+            void ClearReadWriteSet(void);
 
             friend bool operator == (const Transaction &trans1, const Transaction &trans2);
 
         protected:
-            int m_nodeId;
-            int m_transId;
-            int m_transSizeByte;
+            enum Flags {
+                VALIDATED = 1 << 0
+            };
+
+            TxId m_id;
             double m_timeStamp;
-            bool m_validatation; 
-            int m_execution;
+            uint32_t m_transSizeByte;
+            int32_t m_execution : 24;
+            uint32_t m_flags : 8;
+            uint32_t m_readWriteSetOffset;
+            uint16_t m_readCount;
+            uint16_t m_writeCount;
     };
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -36,6 +36,12 @@ namespace ns3 {
         SENDHEADERS
     };
 
+    enum WireFormat
+    {
+        JSON_FORMAT,
+        BINARY_FORMAT
+    };
+
     enum Cryptocurrency
     {
         ETHEREUM,
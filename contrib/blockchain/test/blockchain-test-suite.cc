@@ -2,6 +2,15 @@
 
 // Include a header file from your module to test.
 #include "ns3/blockchain.h"
+#include "ns3/blockchain-message.h"
+#include "ns3/blockchain-message-tag.h"
+#include "ns3/receive-buffer.h"
+#include "ns3/transaction-pool.h"
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <utility>
 
 // An essential include is test.h
 #include "ns3/test.h"
@@ -46,6 +55,1071 @@ BlockchainTestCase1::DoRun (void)
   NS_TEST_ASSERT_MSG_EQ_TOL (0.01, 0.01, 0.001, "Numbers are not equal within tolerance");
 }
 
+// Lookups through the (height, minerId) index of Blockchain
+class BlockchainIndexTestCase : public TestCase
+{
+public:
+  BlockchainIndexTestCase ();
+  virtual ~BlockchainIndexTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+BlockchainIndexTestCase::BlockchainIndexTestCase ()
+  : TestCase ("Blockchain block and orphan index lookups")
+{
+}
+
+BlockchainIndexTestCase::~BlockchainIndexTestCase ()
+{
+}
+
+void
+BlockchainIndexTestCase::DoRun (void)
+{
+  Blockchain blockchain;
+
+  blockchain.AddBlock (Block (1, 3, 0, 0, 0, 1.0, 1.0, Ipv4Address ("10.0.0.1")));
+  blockchain.AddBlock (Block (1, 4, 0, 0, 0, 1.0, 1.0, Ipv4Address ("10.0.0.1")));
+  blockchain.AddBlock (Block (3, 4, 0, 4, 0, 3.0, 3.0, Ipv4Address ("10.0.0.1")));
+
+  NS_TEST_ASSERT_MSG_EQ (blockchain.HasBlock (0, 0), true, "Genesis block must be indexed");
+  NS_TEST_ASSERT_MSG_EQ (blockchain.HasBlock (1, 4), true, "Second block at height 1 not found");
+  NS_TEST_ASSERT_MSG_EQ (blockchain.HasBlock (3, 4), true, "Block above an empty height not found");
+  NS_TEST_ASSERT_MSG_EQ (blockchain.HasBlock (2, 4), false, "Unknown block reported as present");
+  NS_TEST_ASSERT_MSG_EQ (blockchain.GetBlockPointer (Block (1, 4, 0, 0, 0, 0, 0, Ipv4Address ()))->GetMinerId (), 4,
+                         "Block pointer refers to the wrong block");
+  NS_TEST_ASSERT_MSG_EQ (blockchain.ReturnBlock (3, 4).GetTimeStamp (), 3.0, "ReturnBlock returned the wrong block");
+
+  Block genesis = blockchain.ReturnBlock (0, 0);
+  NS_TEST_ASSERT_MSG_EQ (blockchain.GetChildrenPointers (genesis).size (), 2, "Genesis should have two children");
+  NS_TEST_ASSERT_MSG_EQ (blockchain.GetParent (blockchain.ReturnBlock (1, 3)), blockchain.GetBlockPointer (genesis),
+                         "Parent of a height 1 block must be genesis");
+  NS_TEST_ASSERT_MSG_EQ (blockchain.GetParent (blockchain.ReturnBlock (3, 4)), nullptr, "Missing parent must not be found");
+
+  // Handles and pointers must survive growth of the ledger
+  BlockHandle handle = blockchain.GetBlockHandle (1, 4);
+  const Block *pointer = &blockchain.GetBlock (handle);
+  for (int height = 4; height < 1000; height++)
+    {
+      blockchain.AddBlock (Block (height, 4, 0, 4, 0, height, height, Ipv4Address ("10.0.0.1")));
+    }
+  NS_TEST_ASSERT_MSG_EQ (&blockchain.GetBlock (handle), pointer, "Block moved after insertions");
+  NS_TEST_ASSERT_MSG_EQ (blockchain.GetBlockPointer (Block (1, 4, 0, 0, 0, 0, 0, Ipv4Address ())), pointer,
+                         "Block pointer changed after insertions");
+
+  Block orphan1 (5, 1, 0, 2, 0, 5.0, 5.0, Ipv4Address ("10.0.0.2"));
+  Block orphan2 (5, 2, 0, 2, 0, 5.0, 5.0, Ipv4Address ("10.0.0.2"));
+  Block orphan3 (6, 1, 0, 1, 0, 6.0, 6.0, Ipv4Address ("10.0.0.2"));
+  blockchain.AddOrphan (orphan1);
+  blockchain.AddOrphan (orphan2);
+  blockchain.AddOrphan (orphan3);
+  blockchain.RemoveOrphan (orphan1);
+
+  NS_TEST_ASSERT_MSG_EQ (blockchain.isOrphan (5, 1), false, "Removed orphan still reported");
+  NS_TEST_ASSERT_MSG_EQ (blockchain.isOrphan (5, 2), true, "Orphan lost after removing another one");
+  NS_TEST_ASSERT_MSG_EQ (blockchain.isOrphan (orphan3), true, "Moved orphan lost its index entry");
+  NS_TEST_ASSERT_MSG_EQ (blockchain.GetNoOrphans (), 2, "Wrong number of orphans");
+  NS_TEST_ASSERT_MSG_EQ (blockchain.GetOrpharnChildrenPointer (Block (4, 2, 0, 0, 0, 0, 0, Ipv4Address ())).size (), 1,
+                         "Removed orphan still listed as a child");
+  NS_TEST_ASSERT_MSG_EQ (blockchain.GetOrpharnChildrenPointer (orphan2).size (), 0, "orphan2 has no children");
+}
+
+// Orphans attach once their parent arrives and are evicted oldest first
+class BlockchainOrphanPoolTestCase : public TestCase
+{
+public:
+  BlockchainOrphanPoolTestCase ();
+  virtual ~BlockchainOrphanPoolTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+BlockchainOrphanPoolTestCase::BlockchainOrphanPoolTestCase ()
+  : TestCase ("Blockchain orphan pool cascading attach and eviction")
+{
+}
+
+BlockchainOrphanPoolTestCase::~BlockchainOrphanPoolTestCase ()
+{
+}
+
+void
+BlockchainOrphanPoolTestCase::DoRun (void)
+{
+  Blockchain blockchain;
+
+  // Chain 0 <- (1,1) <- (2,1) <- (3,1) plus a sibling (3,2), all received before (1,1)
+  blockchain.AddOrphan (Block (2, 1, 0, 1, 100, 2.0, 2.0, Ipv4Address ()));
+  blockchain.AddOrphan (Block (3, 1, 0, 1, 100, 3.0, 3.0, Ipv4Address ()));
+  blockchain.AddOrphan (Block (3, 2, 0, 1, 100, 3.0, 3.0, Ipv4Address ()));
+  blockchain.AddOrphan (Block (7, 7, 0, 7, 100, 7.0, 7.0, Ipv4Address ()));
+
+  int attached = blockchain.AddBlock (Block (1, 1, 0, 0, 100, 1.0, 1.0, Ipv4Address ()));
+
+  NS_TEST_ASSERT_MSG_EQ (attached, 3, "All descendants of the new block should attach");
+  NS_TEST_ASSERT_MSG_EQ (blockchain.HasBlock (3, 2), true, "Grandchild did not attach");
+  NS_TEST_ASSERT_MSG_EQ (blockchain.GetNoOrphans (), 1, "Unrelated orphan should stay in the pool");
+  NS_TEST_ASSERT_MSG_EQ (blockchain.GetBlockchainHeight (), 3, "Wrong height after attaching orphans");
+
+  blockchain.SetOrphanLimits (2, 0);
+  blockchain.AddOrphan (Block (8, 1, 0, 1, 100, 8.0, 8.0, Ipv4Address ()));
+  blockchain.AddOrphan (Block (8, 2, 0, 1, 100, 8.0, 8.0, Ipv4Address ()));
+
+  NS_TEST_ASSERT_MSG_EQ (blockchain.GetNoOrphans (), 2, "Count cap not enforced");
+  NS_TEST_ASSERT_MSG_EQ (blockchain.isOrphan (7, 7), false, "Oldest orphan should be evicted first");
+  NS_TEST_ASSERT_MSG_EQ (blockchain.GetEvictedOrphans (), 1, "Wrong eviction count");
+
+  blockchain.SetOrphanLimits (0, 150);
+  NS_TEST_ASSERT_MSG_EQ (blockchain.GetNoOrphans (), 1, "Byte cap not enforced");
+  NS_TEST_ASSERT_MSG_EQ (blockchain.isOrphan (8, 2), true, "Newest orphan should survive");
+
+  // An orphan above the byte cap is refused and not remembered as seen
+  blockchain.AddOrphan (Block (9, 1, 0, 1, 200, 9.0, 9.0, Ipv4Address ()));
+  NS_TEST_ASSERT_MSG_EQ (blockchain.isOrphan (9, 1), false, "Oversized orphan stored");
+  NS_TEST_ASSERT_MSG_EQ (blockchain.isOrphan (8, 2), true, "Oversized orphan evicted the others");
+  NS_TEST_ASSERT_MSG_EQ (blockchain.MayContainBlock (BlockId (9, 1)), false, "Oversized orphan marked as seen");
+
+  blockchain.SetOrphanLimits (0, 0);
+  blockchain.AddOrphan (Block (9, 1, 0, 1, 200, 9.0, 9.0, Ipv4Address ()));
+  NS_TEST_ASSERT_MSG_EQ (blockchain.isOrphan (9, 1), true, "Refused orphan cannot be stored later");
+}
+
+// The best tip follows the longest chain and reports reorganizations
+class BlockchainForkChoiceTestCase : public TestCase
+{
+public:
+  BlockchainForkChoiceTestCase ();
+  virtual ~BlockchainForkChoiceTestCase ();
+
+private:
+  virtual void DoRun (void);
+  void Reorg (BlockHandle oldTip, BlockHandle newTip, int depth);
+
+  int m_reorgDepth;
+};
+
+BlockchainForkChoiceTestCase::BlockchainForkChoiceTestCase ()
+  : TestCase ("Blockchain fork choice and reorg depth"),
+    m_reorgDepth (0)
+{
+}
+
+BlockchainForkChoiceTestCase::~BlockchainForkChoiceTestCase ()
+{
+}
+
+void
+BlockchainForkChoiceTestCase::Reorg (BlockHandle oldTip, BlockHandle newTip, int depth)
+{
+  m_reorgDepth = depth;
+}
+
+void
+BlockchainForkChoiceTestCase::DoRun (void)
+{
+  Blockchain blockchain;
+  blockchain.SetReorgCallback (MakeCallback (&BlockchainForkChoiceTestCase::Reorg, this));
+
+  blockchain.AddBlock (Block (1, 1, 0, 0, 0, 1.0, 1.0, Ipv4Address ()));
+  blockchain.AddBlock (Block (2, 1, 0, 1, 0, 2.0, 2.0, Ipv4Address ()));
+  blockchain.AddBlock (Block (1, 2, 0, 0, 0, 1.5, 1.5, Ipv4Address ()));
+  blockchain.AddBlock (Block (2, 2, 0, 2, 0, 2.5, 2.5, Ipv4Address ()));
+
+  NS_TEST_ASSERT_MSG_EQ (blockchain.GetCurrentTopBlock ()->GetMinerId (), 1, "Equal length fork must not replace the first tip");
+  NS_TEST_ASSERT_MSG_EQ (blockchain.GetChainTips ().size (), 2, "Two forks should give two tips");
+  NS_TEST_ASSERT_MSG_EQ (m_reorgDepth, 0, "No reorg expected yet");
+
+  blockchain.AddBlock (Block (3, 2, 0, 2, 0, 3.0, 3.0, Ipv4Address ()));
+
+  NS_TEST_ASSERT_MSG_EQ (blockchain.GetCurrentTopBlock ()->GetMinerId (), 2, "Longer fork must become the best tip");
+  NS_TEST_ASSERT_MSG_EQ (blockchain.GetBlockchainHeight (), 3, "Wrong chain height");
+  NS_TEST_ASSERT_MSG_EQ (m_reorgDepth, 2, "Both blocks of the old fork are abandoned");
+  NS_TEST_ASSERT_MSG_EQ (blockchain.GetReorgCount (), 1, "Exactly one reorg expected");
+  NS_TEST_ASSERT_MSG_EQ (blockchain.GetChainTips ().size (), 2, "Extending a tip must not add a tip");
+}
+
+// Pruning keeps headers below the checkpoint and folds fork statistics
+class BlockchainPruningTestCase : public TestCase
+{
+public:
+  BlockchainPruningTestCase ();
+  virtual ~BlockchainPruningTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+BlockchainPruningTestCase::BlockchainPruningTestCase ()
+  : TestCase ("Blockchain pruning and checkpoint statistics")
+{
+}
+
+BlockchainPruningTestCase::~BlockchainPruningTestCase ()
+{
+}
+
+void
+BlockchainPruningTestCase::DoRun (void)
+{
+  Blockchain blockchain;
+
+  for (int height = 1; height <= 10; height++)
+    {
+      Block block (height, 1, 0, height > 1 ? 1 : 0, 0, height, height, Ipv4Address ());
+      block.AddTransaction (Transaction (5, height, height));
+      blockchain.AddBlock (block);
+    }
+  blockchain.AddBlock (Block (2, 2, 0, 1, 0, 2.0, 2.0, Ipv4Address ()));
+  blockchain.AddBlock (Block (3, 2, 0, 2, 0, 3.0, 3.0, Ipv4Address ()));
+
+  NS_TEST_ASSERT_MSG_EQ (blockchain.GetBlocksInForks (), 2, "Wrong number of blocks in forks");
+  NS_TEST_ASSERT_MSG_EQ (blockchain.GetLongestFork (), 2, "Wrong longest fork");
+  NS_TEST_ASSERT_MSG_EQ (blockchain.GetMinedBlocksInMainChain (1), 10, "Wrong main chain blocks of miner 1");
+
+  blockchain.SetPruning (3, true);
+
+  NS_TEST_ASSERT_MSG_EQ (blockchain.GetCheckpointHeight (), 7, "Wrong checkpoint height");
+  NS_TEST_ASSERT_MSG_EQ (blockchain.HasBlock (3, 2), false, "Stale fork below the checkpoint must be dropped");
+  NS_TEST_ASSERT_MSG_EQ (blockchain.ReturnBlock (1, 1).GetTransactions ().size (), 0, "Final block must keep only its header");
+  NS_TEST_ASSERT_MSG_EQ (blockchain.ReturnBlock (9, 1).GetTransactions ().size (), 1, "Recent block lost its transactions");
+  NS_TEST_ASSERT_MSG_EQ (blockchain.GetBlocksInForks (), 2, "Pruned fork blocks must still be counted");
+  NS_TEST_ASSERT_MSG_EQ (blockchain.GetLongestFork (), 2, "Pruned fork length must still be counted");
+  NS_TEST_ASSERT_MSG_EQ (blockchain.GetMinedBlocksInMainChain (1), 10, "Final main chain blocks must still be counted");
+
+  blockchain.AddBlock (Block (11, 1, 0, 1, 0, 11.0, 11.0, Ipv4Address ()));
+  NS_TEST_ASSERT_MSG_EQ (blockchain.GetCheckpointHeight (), 8, "Checkpoint must follow the best tip");
+  NS_TEST_ASSERT_MSG_EQ (blockchain.GetMinedBlocksInMainChain (1), 11, "New block not counted");
+}
+
+// Ledgers of different nodes share one copy of each block
+class BlockchainSharedStoreTestCase : public TestCase
+{
+public:
+  BlockchainSharedStoreTestCase ();
+  virtual ~BlockchainSharedStoreTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+BlockchainSharedStoreTestCase::BlockchainSharedStoreTestCase ()
+  : TestCase ("Blockchain blocks shared between ledgers")
+{
+}
+
+BlockchainSharedStoreTestCase::~BlockchainSharedStoreTestCase ()
+{
+}
+
+void
+BlockchainSharedStoreTestCase::DoRun (void)
+{
+  Blockchain node1;
+  Blockchain node2;
+  Block block (1, 1, 0, 0, 0, 1.0, 1.0, Ipv4Address ("10.0.0.1"));
+  block.AddTransaction (Transaction (1, 1, 1.0));
+
+  node1.AddBlock (block);
+  block.SetTimeReceived (2.0);
+  block.SetReceivedFromIpv4 (Ipv4Address ("10.0.0.2"));
+  node2.AddBlock (block);
+
+  BlockHandle handle1 = node1.GetBlockHandle (1, 1);
+  BlockHandle handle2 = node2.GetBlockHandle (1, 1);
+
+  NS_TEST_ASSERT_MSG_EQ (node1.GetSharedBlock (handle1), node2.GetSharedBlock (handle2), "Both ledgers should share the block");
+  NS_TEST_ASSERT_MSG_EQ (node1.GetBlock (handle1).GetTransactions ().data (), node2.GetBlock (handle2).GetTransactions ().data (),
+                         "Both ledgers should share the transactions");
+  NS_TEST_ASSERT_MSG_EQ (node1.GetSharedBlock (handle1)->GetTimeReceived (), 0.0, "Shared block carries a node's reception time");
+  NS_TEST_ASSERT_MSG_EQ (node1.GetTimeReceived (handle1), 1.0, "Reception time must stay per node");
+  NS_TEST_ASSERT_MSG_EQ (node2.GetTimeReceived (handle2), 2.0, "Reception time must stay per node");
+  NS_TEST_ASSERT_MSG_EQ (node2.ReturnBlock (1, 1).GetReceivedFromIpv4 (), Ipv4Address ("10.0.0.2"),
+                         "ReturnBlock must carry the node's own reception details");
+  NS_TEST_ASSERT_MSG_EQ (node2.GetBlockPointer (block)->GetTimeReceived (), 2.0, "Block pointer must carry the node's own reception time");
+  NS_TEST_ASSERT_MSG_EQ (node2.GetCurrentTopBlock ()->GetReceivedFromIpv4 (), Ipv4Address ("10.0.0.2"),
+                         "Best tip must carry the node's own reception details");
+  NS_TEST_ASSERT_MSG_EQ (node1.GetBlockPointer (block)->GetTimeReceived (), 1.0, "Block pointer must carry the node's own reception time");
+
+  // A block handed over as an rvalue keeps its transaction storage
+  Block moved (2, 1, 0, 1, 0, 2.0, 2.0, Ipv4Address ());
+  moved.AddTransaction (Transaction (1, 2, 2.0));
+  const Transaction *transactions = moved.GetTransactions ().data ();
+  node1.AddBlock (std::move (moved));
+  NS_TEST_ASSERT_MSG_EQ (node1.GetBlock (node1.GetBlockHandle (2, 1)).GetTransactions ().data (), transactions,
+                         "Moved block transactions were copied");
+
+  // Copies share the transaction list until one of them modifies it
+  Block copy (block);
+  NS_TEST_ASSERT_MSG_EQ (copy.GetTransactions ().data (), block.GetTransactions ().data (),
+                         "Block copy duplicated its transactions");
+  Hash256 root = block.GetMerkleRoot ();
+  copy.AddTransaction (Transaction (1, 3, 3.0));
+  NS_TEST_ASSERT_MSG_EQ (block.GetTransactionCount (), 1, "Modifying a copy changed the original");
+  NS_TEST_ASSERT_MSG_EQ (copy.GetTransactionCount (), 2, "Copy lost its new transaction");
+  NS_TEST_ASSERT_MSG_EQ (copy.HasTransaction (1, 3), true, "Copy lost its new transaction");
+  NS_TEST_ASSERT_MSG_EQ (block.HasTransaction (1, 3), false, "Modifying a copy changed the original");
+  NS_TEST_ASSERT_MSG_EQ ((block.GetMerkleRoot () == root), true, "Original Merkle root changed");
+  NS_TEST_ASSERT_MSG_EQ ((copy.GetMerkleRoot () != root), true, "Copy kept a stale Merkle root");
+
+  // Different blocks under the same id are never shared
+  Blockchain node3;
+  Blockchain node4;
+  Block original (3, 5, 1, 1, 0, 3.0, 3.0, Ipv4Address ());
+  Block other (3, 5, 2, 1, 0, 3.0, 3.0, Ipv4Address ());
+  original.AddTransaction (Transaction (5, 1, 3.0));
+  other.AddTransaction (Transaction (5, 2, 3.0));
+  other.AddTransaction (Transaction (5, 3, 3.0));
+  node3.AddBlock (original);
+  node4.AddBlock (other);
+  BlockHandle handle3 = node3.GetBlockHandle (3, 5);
+  BlockHandle handle4 = node4.GetBlockHandle (3, 5);
+  NS_TEST_ASSERT_MSG_EQ ((node3.GetSharedBlock (handle3) != node4.GetSharedBlock (handle4)), true,
+                         "Different blocks under one id were shared");
+  NS_TEST_ASSERT_MSG_EQ (node3.GetBlock (handle3).GetNonce (), 1, "Ledger holds another block's header");
+  NS_TEST_ASSERT_MSG_EQ (node4.GetBlock (handle4).GetNonce (), 2, "Ledger holds another block's header");
+  NS_TEST_ASSERT_MSG_EQ (node4.GetBlock (handle4).GetTransactionCount (), 2, "Ledger holds another block's transactions");
+  NS_TEST_ASSERT_MSG_EQ (node4.GetBlock (handle4).HasTransaction (5, 3), true, "Ledger holds another block's transactions");
+}
+
+// Transactions are located through the ledger-wide index
+class BlockchainTransactionIndexTestCase : public TestCase
+{
+public:
+  BlockchainTransactionIndexTestCase ();
+  virtual ~BlockchainTransactionIndexTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+BlockchainTransactionIndexTestCase::BlockchainTransactionIndexTestCase ()
+  : TestCase ("Blockchain transaction location index")
+{
+}
+
+BlockchainTransactionIndexTestCase::~BlockchainTransactionIndexTestCase ()
+{
+}
+
+void
+BlockchainTransactionIndexTestCase::DoRun (void)
+{
+  Blockchain blockchain;
+  Block fork (1, 1, 0, 0, 0, 1.0, 1.0, Ipv4Address ());
+  fork.AddTransaction (Transaction (9, 1, 0.5));
+  Block main1 (1, 2, 0, 0, 0, 1.0, 1.0, Ipv4Address ());
+  main1.AddTransaction (Transaction (9, 2, 0.5));
+  main1.AddTransaction (Transaction (9, 1, 0.5));
+  Block main2 (2, 2, 0, 2, 0, 2.0, 2.0, Ipv4Address ());
+
+  blockchain.AddBlock (fork);
+  blockchain.AddBlock (main1);
+  blockchain.AddBlock (main2);
+
+  TxLocation location;
+  NS_TEST_ASSERT_MSG_EQ (blockchain.HasTransaction (9, 2), true, "Committed transaction not found");
+  NS_TEST_ASSERT_MSG_EQ (blockchain.HasTransaction (9, 3), false, "Unknown transaction reported");
+  NS_TEST_ASSERT_MSG_EQ (blockchain.GetTransactionLocation (TxId (9, 1), location), true, "Location not found");
+  NS_TEST_ASSERT_MSG_EQ (location.block, blockchain.GetBlockHandle (1, 2), "Main chain location should be preferred");
+  NS_TEST_ASSERT_MSG_EQ (location.position, 1, "Wrong position in the block");
+  NS_TEST_ASSERT_MSG_EQ (blockchain.FindTransaction (TxId (9, 2))->GetTransactionId (), 2, "Wrong transaction returned");
+
+  blockchain.AddBlock (Block (3, 2, 0, 2, 0, 3.0, 3.0, Ipv4Address ()));
+  blockchain.SetPruning (1, true);
+
+  NS_TEST_ASSERT_MSG_EQ (blockchain.GetTransactionLocation (TxId (9, 1), location), true, "Final transaction lost");
+  NS_TEST_ASSERT_MSG_EQ (location.block, blockchain.GetBlockHandle (1, 2), "Dropped fork still indexed");
+  NS_TEST_ASSERT_MSG_EQ (blockchain.FindTransaction (TxId (9, 1)), nullptr, "Pruned block has no transaction body");
+
+  // Large blocks answer membership through their lazily built id index
+  Block large (4, 2, 0, 2, 0, 4.0, 4.0, Ipv4Address ());
+  for (int transId = 200; transId > 0; transId--)
+    {
+      large.AddTransaction (Transaction (5, transId, 0.5));
+    }
+  NS_TEST_ASSERT_MSG_EQ (large.HasTransaction (5, 17), true, "Transaction of a large block not found");
+  NS_TEST_ASSERT_MSG_EQ (large.FindTransaction (TxId (5, 200)), 0, "Wrong position in a large block");
+  NS_TEST_ASSERT_MSG_EQ (large.HasTransaction (5, 201), false, "Unknown transaction found in a large block");
+  large.AddTransaction (Transaction (5, 201, 0.5));
+  NS_TEST_ASSERT_MSG_EQ (large.HasTransaction (5, 201), true, "Index not refreshed after AddTransaction");
+}
+
+class BlockchainSeenFilterTestCase : public TestCase
+{
+public:
+  BlockchainSeenFilterTestCase ();
+  virtual ~BlockchainSeenFilterTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+BlockchainSeenFilterTestCase::BlockchainSeenFilterTestCase ()
+  : TestCase ("Blockchain seen block bloom filter")
+{
+}
+
+BlockchainSeenFilterTestCase::~BlockchainSeenFilterTestCase ()
+{
+}
+
+void
+BlockchainSeenFilterTestCase::DoRun (void)
+{
+  SeenFilter filter (16);
+  uint32_t capacity = filter.GetCapacity ();
+  for (uint32_t i = 0; i <= capacity; i++)
+    {
+      filter.Insert (TxId (1, i).GetPacked ());
+    }
+  NS_TEST_ASSERT_MSG_EQ (filter.NeedsRebuild (), true, "Filter over capacity should ask for a rebuild");
+  for (uint32_t i = 0; i <= capacity; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (filter.MayContain (TxId (1, i).GetPacked ()), true, "False negative");
+    }
+
+  // Enough blocks to force the ledger filter through a rebuild
+  Blockchain blockchain;
+  for (int height = 1; height <= 1500; height++)
+    {
+      blockchain.AddBlock (Block (height, 0, 0, 0, 0, height, height, Ipv4Address ()));
+    }
+  blockchain.AddOrphan (Block (1600, 1, 0, 1, 0, 1.0, 1.0, Ipv4Address ()));
+
+  for (int height = 0; height <= 1500; height++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (blockchain.MayContainBlock (BlockId (height, 0)), true, "Ledger block missing from the filter");
+    }
+  NS_TEST_ASSERT_MSG_EQ (blockchain.MayContainBlock (BlockId (1600, 1)), true, "Orphan missing from the filter");
+
+  int falsePositives = 0;
+  for (int height = 1; height <= 1000; height++)
+    {
+      falsePositives += blockchain.MayContainBlock (BlockId (height, 7));
+    }
+  NS_TEST_ASSERT_MSG_LT (falsePositives, 50, "Filter false positive rate too high");
+}
+
+class BlockchainAncestorTestCase : public TestCase
+{
+public:
+  BlockchainAncestorTestCase ();
+  virtual ~BlockchainAncestorTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+BlockchainAncestorTestCase::BlockchainAncestorTestCase ()
+  : TestCase ("Blockchain skip list ancestor queries")
+{
+}
+
+BlockchainAncestorTestCase::~BlockchainAncestorTestCase ()
+{
+}
+
+void
+BlockchainAncestorTestCase::DoRun (void)
+{
+  Blockchain blockchain;
+  for (int height = 1; height <= 1000; height++)
+    {
+      blockchain.AddBlock (Block (height, 0, 0, 0, 0, height, height, Ipv4Address ()));
+    }
+  // Fork off block 500 of the main chain
+  blockchain.AddBlock (Block (501, 1, 0, 0, 0, 1.0, 1.0, Ipv4Address ()));
+  for (int height = 502; height <= 520; height++)
+    {
+      blockchain.AddBlock (Block (height, 1, 0, 1, 0, height, height, Ipv4Address ()));
+    }
+
+  BlockHandle tip = blockchain.GetBlockHandle (1000, 0);
+  BlockHandle forkTip = blockchain.GetBlockHandle (520, 1);
+
+  for (int height = 0; height <= 1000; height++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (blockchain.GetAncestorAtHeight (tip, height), blockchain.GetBlockHandle (height, 0), "Wrong ancestor");
+    }
+  NS_TEST_ASSERT_MSG_EQ (blockchain.GetAncestorAtHeight (tip, 1001), INVALID_BLOCK_HANDLE, "Ancestor above the block");
+  NS_TEST_ASSERT_MSG_EQ (blockchain.GetAncestorAtHeight (forkTip, 505), blockchain.GetBlockHandle (505, 1), "Wrong fork ancestor");
+  NS_TEST_ASSERT_MSG_EQ (blockchain.GetAncestorAtHeight (forkTip, 300), blockchain.GetBlockHandle (300, 0), "Wrong ancestor below the fork");
+
+  NS_TEST_ASSERT_MSG_EQ (blockchain.FindCommonAncestor (tip, forkTip), blockchain.GetBlockHandle (500, 0), "Wrong fork point");
+  NS_TEST_ASSERT_MSG_EQ (blockchain.FindCommonAncestor (forkTip, blockchain.GetBlockHandle (510, 0)), blockchain.GetBlockHandle (500, 0), "Wrong fork point");
+  NS_TEST_ASSERT_MSG_EQ (blockchain.FindCommonAncestor (tip, blockchain.GetBlockHandle (700, 0)), blockchain.GetBlockHandle (700, 0), "Ancestor of itself");
+  NS_TEST_ASSERT_MSG_EQ (blockchain.IsOnMainChain (blockchain.GetBlockHandle (505, 1)), false, "Fork block on the main chain");
+  NS_TEST_ASSERT_MSG_EQ (blockchain.IsOnMainChain (blockchain.GetBlockHandle (505, 0)), true, "Main chain block missed");
+  NS_TEST_ASSERT_MSG_EQ (blockchain.GetLongestFork (), 20, "Wrong longest fork");
+  NS_TEST_ASSERT_MSG_EQ (blockchain.GetBlocksInForks (), 20, "Wrong blocks in forks");
+
+  // A parent inserted after its children must link them to the rest of the chain
+  Blockchain late;
+  late.AddBlock (Block (1, 2, 0, 0, 0, 1.0, 1.0, Ipv4Address ()));
+  late.AddBlock (Block (2, 1, 0, 1, 0, 2.0, 2.0, Ipv4Address ()));
+  late.AddBlock (Block (3, 1, 0, 1, 0, 3.0, 3.0, Ipv4Address ()));
+  late.AddBlock (Block (1, 1, 0, 0, 0, 1.0, 1.0, Ipv4Address ()));
+
+  BlockHandle lateTip = late.GetBlockHandle (3, 1);
+  NS_TEST_ASSERT_MSG_EQ (late.GetBestTip (), lateTip, "Wrong best tip after a late parent");
+  NS_TEST_ASSERT_MSG_EQ (late.GetAncestorAtHeight (lateTip, 1), late.GetBlockHandle (1, 1), "Late parent not linked");
+  NS_TEST_ASSERT_MSG_EQ (late.FindCommonAncestor (lateTip, late.GetBlockHandle (1, 2)), late.GetBlockHandle (0, 0),
+                         "Wrong fork point below a late parent");
+  NS_TEST_ASSERT_MSG_EQ (late.IsOnMainChain (late.GetBlockHandle (1, 1)), true, "Late parent not on the main chain");
+  NS_TEST_ASSERT_MSG_EQ (late.IsOnMainChain (late.GetBlockHandle (1, 2)), false, "Fork block on the main chain");
+  NS_TEST_ASSERT_MSG_EQ (late.GetChainTips ().size (), 2, "A late parent must not be a tip");
+}
+
+class BlockchainSnapshotTestCase : public TestCase
+{
+public:
+  BlockchainSnapshotTestCase ();
+  virtual ~BlockchainSnapshotTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+BlockchainSnapshotTestCase::BlockchainSnapshotTestCase ()
+  : TestCase ("Blockchain snapshot and restore")
+{
+}
+
+BlockchainSnapshotTestCase::~BlockchainSnapshotTestCase ()
+{
+}
+
+void
+BlockchainSnapshotTestCase::DoRun (void)
+{
+  Blockchain blockchain;
+  Block first (1, 1, 0, 0, 0, 1.0, 1.5, Ipv4Address ("10.0.0.1"));
+  first.AddTransaction (Transaction (4, 1, 0.5));
+  blockchain.AddBlock (first);
+  blockchain.AddBlock (Block (1, 2, 0, 0, 0, 1.0, 1.0, Ipv4Address ()));
+  for (int height = 2; height <= 6; height++)
+    {
+      Block block (height, 1, 0, 1, 0, height, height, Ipv4Address ());
+      block.AddTransaction (Transaction (4, height, 0.5));
+      blockchain.AddBlock (block);
+    }
+  blockchain.AddOrphan (Block (9, 3, 0, 3, 0, 9.0, 9.0, Ipv4Address ()));
+  blockchain.SetPruning (3, false);
+
+  std::stringstream snapshot;
+  blockchain.Save (snapshot);
+
+  Blockchain restored;
+  NS_TEST_ASSERT_MSG_EQ (restored.Restore (snapshot), true, "Snapshot not restored");
+  NS_TEST_ASSERT_MSG_EQ (restored.GetTotalBlocks (), blockchain.GetTotalBlocks (), "Wrong block count");
+  NS_TEST_ASSERT_MSG_EQ (restored.GetBlockchainHeight (), 6, "Wrong height");
+  NS_TEST_ASSERT_MSG_EQ (restored.GetCurrentTopBlock ()->GetBlockId (), BlockId (6, 1), "Wrong best tip");
+  NS_TEST_ASSERT_MSG_EQ (restored.HasBlock (1, 2), true, "Fork block lost");
+  NS_TEST_ASSERT_MSG_EQ (restored.isOrphan (9, 3), true, "Orphan lost");
+  NS_TEST_ASSERT_MSG_EQ (restored.GetCheckpointHeight (), blockchain.GetCheckpointHeight (), "Pruning state lost");
+  NS_TEST_ASSERT_MSG_EQ (restored.GetBlocksInForks (), blockchain.GetBlocksInForks (), "Wrong blocks in forks");
+  NS_TEST_ASSERT_MSG_EQ (restored.GetMinedBlocksInMainChain (1), 6, "Wrong mined blocks");
+
+  BlockHandle handle = restored.GetBlockHandle (1, 1);
+  NS_TEST_ASSERT_MSG_EQ (restored.GetTimeReceived (handle), 1.5, "Reception time lost");
+  NS_TEST_ASSERT_MSG_EQ (restored.GetReceivedFromIpv4 (handle), Ipv4Address ("10.0.0.1"), "Sender lost");
+  NS_TEST_ASSERT_MSG_EQ (restored.GetBlock (handle).GetTransactionCount (), 0, "Final block should keep its header only");
+  NS_TEST_ASSERT_MSG_EQ (restored.HasTransaction (4, 1), true, "Pruned transaction index lost");
+  NS_TEST_ASSERT_MSG_EQ (restored.FindTransaction (TxId (4, 6))->GetTransactionId (), 6, "Live transaction lost");
+
+  std::stringstream truncated (snapshot.str ().substr (0, 20));
+  NS_TEST_ASSERT_MSG_EQ (restored.Restore (truncated), false, "Truncated snapshot accepted");
+  NS_TEST_ASSERT_MSG_EQ (restored.GetBlockchainHeight (), 6, "Failed restore changed the ledger");
+}
+
+class BlockchainTransactionPoolTestCase : public TestCase
+{
+public:
+  BlockchainTransactionPoolTestCase ();
+  virtual ~BlockchainTransactionPoolTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+BlockchainTransactionPoolTestCase::BlockchainTransactionPoolTestCase ()
+  : TestCase ("Blockchain transaction pool stages")
+{
+}
+
+BlockchainTransactionPoolTestCase::~BlockchainTransactionPoolTestCase ()
+{
+}
+
+void
+BlockchainTransactionPoolTestCase::DoRun (void)
+{
+  TransactionPool pool;
+  Transaction transaction (3, 7, 1.5);
+  transaction.SetExecution (4);
+  transaction.SetValidation ();
+
+  TransactionSlot slot = pool.Add (transaction, TransactionPool::RECEIVED);
+  NS_TEST_ASSERT_MSG_EQ (pool.Has (TxId (3, 7), TransactionPool::RECEIVED), true, "Transaction not received");
+  NS_TEST_ASSERT_MSG_EQ (pool.Has (TxId (3, 7), TransactionPool::REPLY), false, "Transaction in the wrong stage");
+  NS_TEST_ASSERT_MSG_EQ (pool.Get (slot).GetExecution (), 4, "Executor lost");
+  NS_TEST_ASSERT_MSG_EQ (pool.Get (slot).IsValidated (), true, "Validation lost");
+  NS_TEST_ASSERT_MSG_EQ (pool.Get (slot).GetTransTimeStamp (), 1.5, "Timestamp lost");
+
+  pool.SetStage (TxId (3, 7), TransactionPool::REPLY);
+  NS_TEST_ASSERT_MSG_EQ (pool.Add (transaction, TransactionPool::RESULT), slot, "Known transaction moved to another slot");
+  NS_TEST_ASSERT_MSG_EQ (pool.GetStages (slot), TransactionPool::RECEIVED | TransactionPool::REPLY | TransactionPool::RESULT,
+                         "Wrong stages");
+
+  pool.ClearStage (TxId (3, 7), TransactionPool::RECEIVED | TransactionPool::RESULT);
+  NS_TEST_ASSERT_MSG_EQ (pool.Has (TxId (3, 7)), true, "Transaction still in a stage was released");
+  pool.ClearStage (TxId (3, 7), TransactionPool::REPLY);
+  NS_TEST_ASSERT_MSG_EQ (pool.Has (TxId (3, 7)), false, "Transaction in no stage was kept");
+  NS_TEST_ASSERT_MSG_EQ (pool.Add (Transaction (3, 8, 2.0), TransactionPool::MESSAGE), slot, "Free slot not reused");
+  NS_TEST_ASSERT_MSG_EQ (pool.GetSize (), 1, "Wrong pool size");
+
+  // Replies from two executors coexist and leave the received copy alone
+  Transaction received (5, 1, 3.0);
+  received.SetExecution (1);
+  received.SetValidation ();
+  Transaction reply1 (5, 1, 3.0);
+  reply1.SetExecution (2);
+  Transaction reply2 (5, 1, 3.0);
+  reply2.SetExecution (3);
+
+  slot = pool.Add (received, TransactionPool::RECEIVED);
+  pool.Add (reply1, TransactionPool::REPLY);
+  pool.Add (reply2, TransactionPool::REPLY | TransactionPool::RESULT);
+  NS_TEST_ASSERT_MSG_EQ (pool.HasReply (TxId (5, 1), 2), true, "First reply lost");
+  NS_TEST_ASSERT_MSG_EQ (pool.HasReply (TxId (5, 1), 3), true, "Second reply lost");
+  NS_TEST_ASSERT_MSG_EQ (pool.HasReply (TxId (5, 1), 1), false, "Received copy reported as a reply");
+  NS_TEST_ASSERT_MSG_EQ (pool.GetExecution (slot), 1, "A reply overwrote the received executor");
+  NS_TEST_ASSERT_MSG_EQ (pool.IsValidated (slot), true, "A reply overwrote the received validation");
+
+  pool.ClearStage (TxId (5, 1), TransactionPool::REPLY);
+  NS_TEST_ASSERT_MSG_EQ (pool.HasReply (TxId (5, 1), 2), false, "Cleared reply still reported");
+}
+
+class BlockchainHashTestCase : public TestCase
+{
+public:
+  BlockchainHashTestCase ();
+  virtual ~BlockchainHashTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+BlockchainHashTestCase::BlockchainHashTestCase ()
+  : TestCase ("Blockchain SHA-256 header hashes and Merkle roots")
+{
+}
+
+BlockchainHashTestCase::~BlockchainHashTestCase ()
+{
+}
+
+void
+BlockchainHashTestCase::DoRun (void)
+{
+  Hash256 hash;
+  Sha256::Hash (reinterpret_cast<const uint8_t *> ("abc"), 3, hash);
+  NS_TEST_ASSERT_MSG_EQ (HashToString (hash), "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad", "Wrong SHA-256");
+
+  Block block (1, 1, 0, 0, 0, 1.0, 1.0, Ipv4Address ());
+  NS_TEST_ASSERT_MSG_EQ (HashToString (block.GetMerkleRoot ()), std::string (64, '0'), "Empty block must have a zero root");
+
+  block.AddTransaction (Transaction (1, 1, 0.5));
+  Hash256 single = block.GetMerkleRoot ();
+  block.AddTransaction (Transaction (1, 2, 0.5));
+  block.AddTransaction (Transaction (1, 3, 0.5));
+  Hash256 root = block.GetMerkleRoot ();
+  NS_TEST_ASSERT_MSG_NE (root, single, "Cached root not refreshed");
+
+  // Rebuild the three transaction tree by hand: the last leaf is paired with itself
+  uint8_t leaves[3 * 32];
+  uint8_t pairs[4 * 32];
+  for (int i = 0; i < 3; i++)
+    {
+      Block leaf (1, 1, 0, 0, 0, 1.0, 1.0, Ipv4Address ());
+      leaf.AddTransaction (Transaction (1, i + 1, 0.5));
+      std::memcpy (leaves + 32 * i, leaf.GetMerkleRoot ().data (), 32);
+    }
+  std::memcpy (pairs, leaves, 64);
+  std::memcpy (pairs + 64, leaves + 64, 32);
+  std::memcpy (pairs + 96, leaves + 64, 32);
+  Sha256::DoubleHash64 (pairs, pairs, 2);
+  Sha256::DoubleHash64 (pairs, pairs, 1);
+  NS_TEST_ASSERT_MSG_EQ (std::memcmp (pairs, root.data (), 32), 0, "Wrong Merkle root");
+  NS_TEST_ASSERT_MSG_EQ (block.GetHashCompressions (), 3 + 3 * 2 + 2 * 3 + 1 * 3, "Wrong compression count");
+
+  // Every kernel the CPU supports must agree with the portable code
+  Block large (2, 1, 0, 1, 0, 2.0, 2.0, Ipv4Address ());
+  for (int transId = 0; transId < 1001; transId++)
+    {
+      large.AddTransaction (Transaction (2, transId, transId * 0.25));
+    }
+  Sha256::Implementation best = Sha256::GetImplementation ();
+  Sha256::SetImplementation (Sha256::PORTABLE);
+  Hash256 expected = Block (large).GetHeaderHash ();
+  for (int implementation = Sha256::SSE4; implementation <= Sha256::SHANI; implementation++)
+    {
+      if (Sha256::IsSupported (static_cast<Sha256::Implementation> (implementation)))
+        {
+          Sha256::SetImplementation (static_cast<Sha256::Implementation> (implementation));
+          NS_TEST_ASSERT_MSG_EQ (Block (large).GetHeaderHash (), expected,
+                                 "Header hash differs with " << Sha256::GetImplementationName (Sha256::GetImplementation ()));
+        }
+    }
+  Sha256::SetImplementation (best);
+}
+
+// Read/write sets live in the arena of their block
+class BlockchainReadWriteSetTestCase : public TestCase
+{
+public:
+  BlockchainReadWriteSetTestCase ();
+  virtual ~BlockchainReadWriteSetTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+BlockchainReadWriteSetTestCase::BlockchainReadWriteSetTestCase ()
+  : TestCase ("Blockchain transaction read/write sets")
+{
+}
+
+BlockchainReadWriteSetTestCase::~BlockchainReadWriteSetTestCase ()
+{
+}
+
+void
+BlockchainReadWriteSetTestCase::DoRun (void)
+{
+  ReadWriteEntry reads[2] = {{10, 1, 0}, {11, 4, 0}};
+  ReadWriteEntry writes[1] = {{10, 2, 100}};
+  Block block (1, 1, 0, 0, 0, 1.0, 1.0, Ipv4Address ());
+
+  block.AddTransaction (Transaction (1, 1, 1.0), reads, 2, writes, 1);
+  block.AddTransaction (Transaction (1, 2, 1.0));
+  block.AddTransaction (Transaction (1, 3, 1.0), nullptr, 0, writes, 1);
+
+  NS_TEST_ASSERT_MSG_EQ (block.GetReadWriteSets ().GetSize (), 4, "Sets must be packed into the block arena");
+  NS_TEST_ASSERT_MSG_EQ (block.GetTransaction (0).GetReadCount (), 2, "Wrong read count");
+  NS_TEST_ASSERT_MSG_EQ (block.GetTransaction (0).GetWriteCount (), 1, "Wrong write count");
+  NS_TEST_ASSERT_MSG_EQ (block.GetReads (0)[1].key, 11, "Wrong read key");
+  NS_TEST_ASSERT_MSG_EQ (block.GetWrites (0)[0].version, 2, "Wrong written version");
+  NS_TEST_ASSERT_MSG_EQ (block.GetTransaction (1).HasReadWriteSet (), false, "Transaction without a set got one");
+  NS_TEST_ASSERT_MSG_EQ (block.GetWrites (2)[0].valueSize, 100, "Wrong written value size");
+  NS_TEST_ASSERT_MSG_EQ (block.GetReadWriteSetBytes (0), 2 * 12 + 8 + 100, "Wrong endorsement payload size");
+
+  // A transaction taken from another block leaves its set behind
+  Block other (1, 2, 0, 0, 0, 1.0, 1.0, Ipv4Address ());
+  other.AddTransaction (block.GetTransaction (0));
+  NS_TEST_ASSERT_MSG_EQ (other.GetTransaction (0).HasReadWriteSet (), false, "Set refers to another block's arena");
+  other.SetTransactions (block.GetTransactions ());
+  NS_TEST_ASSERT_MSG_EQ (other.GetTransaction (0).HasReadWriteSet (), false, "Set refers to another block's arena");
+
+
+  // A set copied from the same block survives the arena growing under it
+  for (int transId = 10; transId < 30; transId++)
+    {
+      block.AddTransaction (Transaction (1, transId, 1.0), block.GetReads (0), 2, block.GetWrites (0), 1);
+    }
+  NS_TEST_ASSERT_MSG_EQ (block.GetReads (22)[1].key, 11, "Set copied within a block was corrupted");
+  NS_TEST_ASSERT_MSG_EQ (block.GetWrites (22)[0].valueSize, 100, "Set copied within a block was corrupted");
+
+  // Sets are kept only together with the arena they were built in
+  ReadWriteArena arena (block.GetReadWriteSets ());
+  other.SetTransactions (std::vector<Transaction> (block.GetTransactions ()), std::move (arena));
+  NS_TEST_ASSERT_MSG_EQ (other.GetReads (0)[1].key, 11, "Set lost with its own arena");
+
+  // Sets survive a snapshot and are freed with the transactions when the block is pruned
+  Blockchain blockchain;
+  blockchain.AddBlock (block);
+  for (int height = 2; height <= 4; height++)
+    {
+      blockchain.AddBlock (Block (height, 1, 0, 1, 0, height, height, Ipv4Address ()));
+    }
+
+  std::stringstream stream;
+  blockchain.Save (stream);
+  Blockchain restored;
+  NS_TEST_ASSERT_MSG_EQ (restored.Restore (stream), true, "Snapshot not restored");
+  const Block &copy = restored.ReturnBlock (1, 1);
+  NS_TEST_ASSERT_MSG_EQ (copy.GetReads (0)[0].key, 10, "Read set lost in the snapshot");
+  NS_TEST_ASSERT_MSG_EQ (copy.GetReadWriteSetBytes (2), 108, "Write set lost in the snapshot");
+
+  blockchain.SetPruning (2, false);
+  NS_TEST_ASSERT_MSG_EQ (blockchain.ReturnBlock (1, 1).GetReadWriteSets ().GetSize (), 0, "Pruned block kept its read/write sets");
+}
+
+// Messages survive both wire formats and binary frames are found by length
+class BlockchainMessageCodecTestCase : public TestCase
+{
+public:
+  BlockchainMessageCodecTestCase ();
+  virtual ~BlockchainMessageCodecTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+BlockchainMessageCodecTestCase::BlockchainMessageCodecTestCase ()
+  : TestCase ("Blockchain message JSON and binary codecs")
+{
+}
+
+BlockchainMessageCodecTestCase::~BlockchainMessageCodecTestCase ()
+{
+}
+
+void
+BlockchainMessageCodecTestCase::DoRun (void)
+{
+  BlockchainMessage inv (INV);
+  inv.blockIds.push_back (BlockId (7, 3));
+  inv.blockIds.push_back (BlockId (8, -1));
+
+  BlockchainMessage block (BLOCK);
+  block.blocks.push_back (Block (7, 3, 11, 2, 4000, 1.5, 2.5, Ipv4Address ("10.0.0.3")));
+  Transaction trans (4, 9, 0.25);
+  trans.SetTransSizeByte (300);
+  trans.SetExecution (6);
+  trans.SetValidation ();
+  block.blocks[0].AddTransaction (trans);
+  ReadWriteEntry reads[2] = {{10, 1, 0}, {UINT64_C (1) << 40, 4, 0}};
+  ReadWriteEntry writes[1] = {{10, 2, 100}};
+  block.blocks[0].AddTransaction (Transaction (4, 10, 0.5), reads, 2, writes, 1);
+
+  BlockchainMessage reply (REPLY_TRANS);
+  reply.transactions.push_back (trans);
+
+  WireFormat formats[] = {JSON_FORMAT, BINARY_FORMAT};
+  for (WireFormat format : formats)
+    {
+      MessageCodec codec (format);
+      std::string stream;
+      codec.Encode (inv, stream);
+      codec.Encode (block, stream);
+      codec.Encode (reply, stream);
+
+      std::vector<BlockchainMessage> decoded;
+      size_t offset = 0;
+      size_t frameSize;
+      size_t payloadOffset;
+      size_t payloadSize;
+      bool corrupt;
+      while ((frameSize = codec.FindFrame (stream.data () + offset, stream.size () - offset,
+                                           payloadOffset, payloadSize, corrupt)) > 0)
+        {
+          BlockchainMessage message;
+          NS_TEST_ASSERT_MSG_EQ (codec.Decode (&stream[offset + payloadOffset], payloadSize, message), true, "Frame did not decode");
+          decoded.push_back (message);
+          offset += frameSize;
+        }
+
+      NS_TEST_ASSERT_MSG_EQ (offset, stream.size (), "Frames left undecoded");
+      NS_TEST_ASSERT_MSG_EQ (decoded.size (), 3, "Wrong number of frames");
+      NS_TEST_ASSERT_MSG_EQ (decoded[0].type, INV, "Wrong message type");
+      NS_TEST_ASSERT_MSG_EQ (decoded[0].blockIds.size (), 2, "Wrong inventory size");
+      NS_TEST_ASSERT_MSG_EQ (decoded[0].blockIds[1], BlockId (8, -1), "Wrong inventory entry");
+
+      const Block &received = decoded[1].blocks[0];
+      NS_TEST_ASSERT_MSG_EQ (received.GetNonce (), 11, "Wrong block nonce");
+      NS_TEST_ASSERT_MSG_EQ (received.GetBlockSizeBytes (), 4000, "Wrong block size");
+      NS_TEST_ASSERT_MSG_EQ (received.GetTimeReceived (), 2.5, "Wrong block reception time");
+      NS_TEST_ASSERT_MSG_EQ (received.GetReceivedFromIpv4 (), Ipv4Address ("10.0.0.3"), "Wrong block sender");
+      NS_TEST_ASSERT_MSG_EQ (received.GetTransactionCount (), 2, "Block lost its transactions");
+      NS_TEST_ASSERT_MSG_EQ ((received.GetMerkleRoot () == block.blocks[0].GetMerkleRoot ()), true, "Block transactions changed");
+
+      // Read/write sets travel with the block's transactions
+      NS_TEST_ASSERT_MSG_EQ (received.GetTransaction (0).HasReadWriteSet (), false, "Set made up for a transaction");
+      NS_TEST_ASSERT_MSG_EQ (received.GetTransaction (1).GetReadCount (), 2, "Reads lost");
+      NS_TEST_ASSERT_MSG_EQ (received.GetTransaction (1).GetWriteCount (), 1, "Writes lost");
+      NS_TEST_ASSERT_MSG_EQ (received.GetReads (1)[1].key, UINT64_C (1) << 40, "Wrong read key");
+      NS_TEST_ASSERT_MSG_EQ (received.GetReads (1)[1].version, 4, "Wrong read version");
+      NS_TEST_ASSERT_MSG_EQ (received.GetWrites (1)[0].version, 2, "Wrong write version");
+      NS_TEST_ASSERT_MSG_EQ (received.GetWrites (1)[0].valueSize, 100, "Wrong write value size");
+      NS_TEST_ASSERT_MSG_EQ (received.GetReadWriteSetBytes (1), block.blocks[0].GetReadWriteSetBytes (1), "Wrong set size");
+
+      const Transaction &replied = decoded[2].transactions[0];
+      NS_TEST_ASSERT_MSG_EQ (replied.GetTxId (), trans.GetTxId (), "Wrong transaction id");
+      NS_TEST_ASSERT_MSG_EQ (replied.GetTransTimeStamp (), 0.25, "Wrong transaction timestamp");
+      NS_TEST_ASSERT_MSG_EQ (replied.GetExecution (), 6, "Wrong transaction execution");
+      NS_TEST_ASSERT_MSG_EQ (replied.IsValidated (), true, "Transaction lost its validation");
+
+      // A frame cut short waits for more bytes
+      std::string partial;
+      codec.Encode (block, partial);
+      NS_TEST_ASSERT_MSG_EQ (codec.FindFrame (partial.data (), partial.size () - 1, payloadOffset, payloadSize, corrupt),
+                             0, "Incomplete frame reported");
+      NS_TEST_ASSERT_MSG_EQ (corrupt, false, "Incomplete frame reported as corrupt");
+    }
+
+  MessageCodec binaryCodec (BINARY_FORMAT);
+  std::string binary;
+  binaryCodec.Encode (inv, binary);
+  BlockchainMessage message;
+  NS_TEST_ASSERT_MSG_EQ (binary.size (), 4 + 1 + 4 + 2 * 8, "Binary INV is not compact");
+  NS_TEST_ASSERT_MSG_EQ (binaryCodec.Decode (&binary[4], binary.size () - 5, message), false, "Truncated payload decoded");
+
+  size_t payloadOffset;
+  size_t payloadSize;
+  bool corrupt;
+  const char huge[] = {'\xff', '\xff', '\xff', '\xff'};
+  binaryCodec.FindFrame (huge, sizeof (huge), payloadOffset, payloadSize, corrupt);
+  NS_TEST_ASSERT_MSG_EQ (corrupt, true, "Oversized frame accepted");
+
+  MessageCodec jsonCodec (JSON_FORMAT);
+  char malformed[] = "{\"message\":0,\"inv\":[\"x\"]}#";
+  NS_TEST_ASSERT_MSG_EQ (jsonCodec.Decode (malformed, sizeof (malformed) - 2, message), false, "Malformed inventory decoded");
+
+  // The reused parser state copes with messages larger than its pool, and with the ones after them
+  BlockchainMessage large (GET_DATA);
+  for (int height = 0; height < 5000; height++)
+    {
+      large.blockIds.push_back (BlockId (height, 1));
+    }
+  for (const BlockchainMessage *sent : {&large, &inv, &large, &inv})
+    {
+      std::string json;
+      jsonCodec.Encode (*sent, json);
+      jsonCodec.FindFrame (json.data (), json.size (), payloadOffset, payloadSize, corrupt);
+      NS_TEST_ASSERT_MSG_EQ (jsonCodec.Decode (&json[payloadOffset], payloadSize, message), true, "Message not decoded");
+      NS_TEST_ASSERT_MSG_EQ (message.blockIds.size (), sent->blockIds.size (), "Wrong number of block ids");
+      NS_TEST_ASSERT_MSG_EQ (message.blockIds.back (), sent->blockIds.back (), "Wrong block id");
+    }
+
+  // A message carried as a packet tag comes back whole after the tag is serialized
+  binary.clear ();
+  binaryCodec.Encode (inv, binary);
+  BlockchainMessageTag tag (binary);
+  std::vector<uint8_t> tagBytes (tag.GetSerializedSize ());
+  tag.Serialize (TagBuffer (tagBytes.data (), tagBytes.data () + tagBytes.size ()));
+  std::string tagged;
+  BlockchainMessageTag received (tagged);
+  received.Deserialize (TagBuffer (tagBytes.data (), tagBytes.data () + tagBytes.size ()));
+  NS_TEST_ASSERT_MSG_EQ ((tagged == binary), true, "Tag not deserialized into its buffer");
+  NS_TEST_ASSERT_MSG_EQ (&received.GetFrame (), &tagged, "Tag copied its buffer");
+  BlockchainMessageTag assigned;
+  {
+    // Copies of a tag that keeps its own frame keep theirs
+    BlockchainMessageTag unbound;
+    unbound.Deserialize (TagBuffer (tagBytes.data (), tagBytes.data () + tagBytes.size ()));
+    BlockchainMessageTag copied (unbound);
+    assigned = copied;
+  }
+  NS_TEST_ASSERT_MSG_EQ ((assigned.GetFrame () == binary), true, "Copied tag lost its frame");
+  NS_TEST_ASSERT_MSG_EQ (binaryCodec.FindFrame (tagged.data (), tagged.size (), payloadOffset, payloadSize, corrupt), tagged.size (), "Tagged frame not found");
+  NS_TEST_ASSERT_MSG_EQ (binaryCodec.Decode (&tagged[payloadOffset], payloadSize, message), true, "Tagged message not decoded");
+  NS_TEST_ASSERT_MSG_EQ (message.type, INV, "Wrong tagged message type");
+  NS_TEST_ASSERT_MSG_EQ ((message.blockIds == inv.blockIds), true, "Wrong tagged inventory");
+}
+
+// Received bytes are appended once and consumed frame by frame in place
+class BlockchainReceiveBufferTestCase : public TestCase
+{
+public:
+  BlockchainReceiveBufferTestCase ();
+  virtual ~BlockchainReceiveBufferTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+BlockchainReceiveBufferTestCase::BlockchainReceiveBufferTestCase ()
+  : TestCase ("Blockchain per-peer receive buffer")
+{
+}
+
+BlockchainReceiveBufferTestCase::~BlockchainReceiveBufferTestCase ()
+{
+}
+
+void
+BlockchainReceiveBufferTestCase::DoRun (void)
+{
+  BlockchainMessage inv (INV);
+  size_t payloadOffset;
+  size_t payloadSize;
+  bool corrupt;
+
+  inv.blockIds.push_back (BlockId (1, 1));
+  for (WireFormat format : {BINARY_FORMAT, JSON_FORMAT})
+    {
+      ReceiveBuffer buffer;
+      MessageCodec codec (format);
+      std::string stream;
+
+      for (int i = 0; i < 3; i++)
+        {
+          codec.Encode (inv, stream);
+        }
+
+      // Frames split across packets are parsed once complete
+      int frames = 0;
+      size_t capacity = 0;
+      for (int round = 0; round < 100; round++)
+        {
+          for (size_t sent = 0; sent < stream.size (); sent += 7)
+            {
+              size_t size = std::min<size_t> (7, stream.size () - sent);
+              std::memcpy (buffer.Prepare (size), stream.data () + sent, size);
+              buffer.Commit (size);
+
+              size_t frameSize;
+              while ((frameSize = codec.FindFrame (buffer.GetData (), buffer.GetSize (), buffer.GetScanned (),
+                                                   payloadOffset, payloadSize, corrupt)) > 0)
+                {
+                  BlockchainMessage message;
+                  NS_TEST_ASSERT_MSG_EQ (codec.Decode (buffer.GetData () + payloadOffset, payloadSize, message),
+                                         true, "Frame corrupted by buffering");
+                  buffer.Consume (frameSize);
+                  frames++;
+                }
+              NS_TEST_ASSERT_MSG_EQ (corrupt, false, "Split frame reported corrupt");
+              if (format == JSON_FORMAT)
+                {
+                  NS_TEST_ASSERT_MSG_EQ (buffer.GetScanned (), buffer.GetSize (), "Partial frame not marked as scanned");
+                }
+            }
+          if (round == 0)
+            {
+              capacity = buffer.GetCapacity ();
+            }
+        }
+
+      NS_TEST_ASSERT_MSG_EQ (frames, 300, "Frames lost in the buffer");
+      NS_TEST_ASSERT_MSG_EQ (buffer.GetSize (), 0, "Consumed bytes left in the buffer");
+      NS_TEST_ASSERT_MSG_EQ (buffer.GetScanned (), 0, "Scan offset kept after the frame was consumed");
+      NS_TEST_ASSERT_MSG_EQ (buffer.GetCapacity (), capacity, "Buffer kept growing in steady state");
+      NS_TEST_ASSERT_MSG_EQ ((capacity < stream.size ()), true, "Buffer held more than a frame and a packet");
+    }
+
+  // A JSON stream that never ends a frame is cut off at the frame size limit
+  ReceiveBuffer buffer;
+  MessageCodec codec (JSON_FORMAT);
+  size_t size = MessageCodec::MAX_FRAME_BYTES + 1;
+  std::memset (buffer.Prepare (size), ' ', size);
+  buffer.Commit (size);
+  NS_TEST_ASSERT_MSG_EQ (codec.FindFrame (buffer.GetData (), buffer.GetSize (), buffer.GetScanned (),
+                                          payloadOffset, payloadSize, corrupt), 0, "Oversized frame found");
+  NS_TEST_ASSERT_MSG_EQ (corrupt, true, "Oversized JSON frame not reported");
+  *buffer.Prepare (1) = MessageCodec::JSON_DELIMITER;
+  buffer.Commit (1);
+  buffer.GetScanned () = 0;
+  NS_TEST_ASSERT_MSG_EQ (codec.FindFrame (buffer.GetData (), buffer.GetSize (), buffer.GetScanned (),
+                                          payloadOffset, payloadSize, corrupt), 0, "Oversized frame found");
+  NS_TEST_ASSERT_MSG_EQ (corrupt, true, "Oversized delimited JSON frame not reported");
+  buffer.Clear ();
+  NS_TEST_ASSERT_MSG_EQ (buffer.GetScanned (), 0, "Scan offset kept after the buffer was cleared");
+}
+
 // The TestSuite class names the TestSuite, identifies what type of TestSuite,
 // and enables the TestCases to be run.  Typically, only the constructor for
 // this class must be defined
@@ -61,6 +1135,20 @@ BlockchainTestSuite::BlockchainTestSuite ()
 {
   // TestDuration for TestCase can be QUICK, EXTENSIVE or TAKES_FOREVER
   AddTestCase (new BlockchainTestCase1, TestCase::QUICK);
+  AddTestCase (new BlockchainIndexTestCase, TestCase::QUICK);
+  AddTestCase (new BlockchainOrphanPoolTestCase, TestCase::QUICK);
+  AddTestCase (new BlockchainForkChoiceTestCase, TestCase::QUICK);
+  AddTestCase (new BlockchainPruningTestCase, TestCase::QUICK);
+  AddTestCase (new BlockchainSharedStoreTestCase, TestCase::QUICK);
+  AddTestCase (new BlockchainTransactionIndexTestCase, TestCase::QUICK);
+  AddTestCase (new BlockchainSeenFilterTestCase, TestCase::QUICK);
+  AddTestCase (new BlockchainAncestorTestCase, TestCase::QUICK);
+  AddTestCase (new BlockchainSnapshotTestCase, TestCase::QUICK);
+  AddTestCase (new BlockchainTransactionPoolTestCase, TestCase::QUICK);
+  AddTestCase (new BlockchainHashTestCase, TestCase::QUICK);
+  AddTestCase (new BlockchainReadWriteSetTestCase, TestCase::QUICK);
+  AddTestCase (new BlockchainMessageCodecTestCase, TestCase::QUICK);
+  AddTestCase (new BlockchainReceiveBufferTestCase, TestCase::QUICK);
 }
 
 // Do not forget to allocate an instance of this TestSuite